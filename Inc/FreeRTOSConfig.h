@@ -84,6 +84,7 @@
 
 /* USER CODE BEGIN Includes */   	      
 /* Section where include file can be added */
+#include "stm32f0xx.h"
 /* USER CODE END Includes */ 
 
 /* Ensure stdint is only used by the compiler, and not the assembler. */
@@ -94,21 +95,24 @@
 #endif
 
 #define configUSE_PREEMPTION                     1
-#define configSUPPORT_STATIC_ALLOCATION          0
-#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
 #define configUSE_IDLE_HOOK                      0
 #define configUSE_TICK_HOOK                      0
+#define configUSE_TICKLESS_IDLE                  1
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
-#define configMAX_PRIORITIES                     ( 7 )
+#define configMAX_PRIORITIES                     ( 4 ) /* osPriorityIdle up to osPriorityNormal, every priority takes a list in the RAM */
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)64)
 #define configTOTAL_HEAP_SIZE                    ((size_t)2048)
-#define configMAX_TASK_NAME_LEN                  ( 12 )
+#define configMAX_TASK_NAME_LEN                  ( 8 ) /* "UARTCmd" and "IDLE" fit, "defaultTask" is shortened to "default" */
 #define configUSE_16_BIT_TICKS                   0
-#define configUSE_MUTEXES                        1
+#define configUSE_MUTEXES                        0 /* no mutex is used, the priority inheritance would take 8 bytes in every TCB */
 #define configQUEUE_REGISTRY_SIZE                0
 #define configCHECK_FOR_STACK_OVERFLOW           1
-#define configUSE_TASK_NOTIFICATIONS             0
+#define configUSE_TASK_NOTIFICATIONS             1
+#define configUSE_TRACE_FACILITY                 1
+#define configGENERATE_RUN_TIME_STATS            1
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES                    0
@@ -121,10 +125,12 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelete                 0
 #define INCLUDE_vTaskCleanUpResources       0
 #define INCLUDE_vTaskSuspend                1
-#define INCLUDE_vTaskDelayUntil             0
+#define INCLUDE_vTaskDelayUntil             1
 #define INCLUDE_vTaskDelay                  1
 #define INCLUDE_xTaskGetSchedulerState      1
 #define INCLUDE_uxTaskGetStackHighWaterMark 1
+#define INCLUDE_xTaskGetIdleTaskHandle      1
+#define INCLUDE_xTaskGetCurrentTaskHandle   1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -156,10 +162,17 @@ header file. */
 /* USER CODE BEGIN 1 */   
 #define configASSERT( x ) if ((x) == 0) {taskDISABLE_INTERRUPTS(); for( ;; );} 
 
-#define configCOMMAND_INT_MAX_OUTPUT_SIZE		600
+#define configCOMMAND_INT_MAX_OUTPUT_SIZE		160
 
 #define configUART_COMMAND_CONSOLE_TASK_PRIORITY	( 3U )
 #define configUART_COMMAND_CONSOLE_STACK_SIZE		( configMINIMAL_STACK_SIZE * 3 )
+
+/* The idle task only puts the core to sleep (tickless idle), its stack holds little more than the saved context */
+#define configIDLE_TASK_STACK_SIZE				( 48 )
+
+/* The commands of the serial console are listed in a table in the flash (see UART_CLI.c),
+ because they can't be registered into the heap without dynamic allocation. */
+#define configAPPLICATION_PROVIDES_COMMAND_TABLE	1
 /* USER CODE END 1 */
 
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
@@ -173,6 +186,13 @@ standard names. */
 
 /* USER CODE BEGIN Defines */   	      
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+#define configPRE_SLEEP_PROCESSING                        PreSleepProcessing
+#define configPOST_SLEEP_PROCESSING                       PostSleepProcessing
+
+/* The run time statistics (see task_stats.h) are counted with the free running 1MHz counter of TIM2,
+ which is already started by MX_TIM2_Init() */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()                  (TIM2->CNT)
 /* USER CODE END Defines */ 
 
 #endif /* FREERTOS_CONFIG_H */
@@ -75,6 +75,20 @@ static portBASE_TYPE prvPowerOff(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 static portBASE_TYPE prvTimeRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
 static portBASE_TYPE prvDateRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
 static portBASE_TYPE prvStatusRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvFailoverLatency(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvADCBenchmark(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvShowThresholds(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvBrownoutStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvADCMode(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvADCStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvStatsRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvCapture(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvSleepStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvSchedule(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvLoopStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvRamReport(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvTaskStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+static portBASE_TYPE prvSetBaud(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
 
 /*** Here you can find  how FreeRTOS needs the command registered
  *
@@ -139,6 +153,48 @@ static const CLI_Command_Definition_t xDateRPi =
 static const CLI_Command_Definition_t xStatusRPi =
 { (const int8_t * const ) "status-rpi", (const int8_t * const ) "", prvStatusRPi, 0 };
 
+static const CLI_Command_Definition_t xFailoverLatency =
+{ (const int8_t * const ) "failover-latency", (const int8_t * const ) "failover-latency [reset]:\r\n Outputs the measured Failover-Latencies of the ADC-Watchdog\r\n\r\n", prvFailoverLatency, -1 };
+
+static const CLI_Command_Definition_t xADCBenchmark =
+{ (const int8_t * const ) "adc-benchmark", (const int8_t * const ) "adc-benchmark:\r\n Compares the CPU-Cycles of the ADC-Voltage conversion\r\n\r\n", prvADCBenchmark, 0 };
+
+static const CLI_Command_Definition_t xShowThresholds =
+{ (const int8_t * const ) "show-thresholds", (const int8_t * const ) "show-thresholds:\r\n Outputs the Fail- and Restore-Thresholds of the primary sources\r\n\r\n", prvShowThresholds, 0 };
+
+static const CLI_Command_Definition_t xBrownoutStatus =
+{ (const int8_t * const ) "brownout-status", (const int8_t * const ) "brownout-status [reset]:\r\n Outputs the counters of the predictive Brown-Out Detection\r\n\r\n", prvBrownoutStatus, -1 };
+
+static const CLI_Command_Definition_t xADCMode =
+{ (const int8_t * const ) "adc-mode", (const int8_t * const ) "adc-mode [rate autooff]:\r\n Outputs or changes the ADC acquisition mode (rate 0: continuous, 1-1000: scans/s)\r\n\r\n", prvADCMode, -1 };
+
+static const CLI_Command_Definition_t xADCStats =
+{ (const int8_t * const ) "adc-stats", (const int8_t * const ) "adc-stats [s|m|h]:\r\n Outputs the min/max/mean/stddev of the last second, minute or hour\r\n\r\n", prvADCStats, -1 };
+
+static const CLI_Command_Definition_t xStatsRPi =
+{ (const int8_t * const ) "stats-rpi", (const int8_t * const ) "", prvStatsRPi, 0 };
+
+static const CLI_Command_Definition_t xCapture =
+{ (const int8_t * const ) "capture", (const int8_t * const ) "capture [arm|dump]:\r\n Outputs, re-arms or reads out the waveform capture of the last powerfailure\r\n\r\n", prvCapture, -1 };
+
+static const CLI_Command_Definition_t xSleepStats =
+{ (const int8_t * const ) "sleep-stats", (const int8_t * const ) "sleep-stats [reset]:\r\n Outputs the fraction of time the STM32 has spent in the SLEEP mode\r\n\r\n", prvSleepStats, -1 };
+
+static const CLI_Command_Definition_t xSchedule =
+{ (const int8_t * const ) "schedule", (const int8_t * const ) "schedule [index minute hour weekdays days action]:\r\n Outputs the schedule table or changes an entry (action: wake, shutdown, interval or off)\r\n\r\n", prvSchedule, -1 };
+
+static const CLI_Command_Definition_t xLoopStats =
+{ (const int8_t * const ) "loop-stats", (const int8_t * const ) "loop-stats [reset]:\r\n Outputs the execution time and the jitter of the main loop\r\n\r\n", prvLoopStats, -1 };
+
+static const CLI_Command_Definition_t xRamReport =
+{ (const int8_t * const ) "ram-report", (const int8_t * const ) "ram-report:\r\n Outputs the static RAM budget and the stack usage of the tasks\r\n\r\n", prvRamReport, 0 };
+
+static const CLI_Command_Definition_t xTaskStats =
+{ (const int8_t * const ) "task-stats", (const int8_t * const ) "task-stats:\r\n Outputs the CPU share and the stack usage of the tasks and the interrupt counts since the last call\r\n\r\n", prvTaskStats, 0 };
+
+static const CLI_Command_Definition_t xSetBaud =
+{ (const int8_t * const ) "set-baud", (const int8_t * const ) "set-baud [rate|ok]:\r\n Switches the baudrate, which has to be confirmed with the new rate within 3 s\r\n\r\n", prvSetBaud, -1 };
+
 int ascii2int(const char* s);
 
 #endif /* UART_COMMAND_CONSOLE_H */
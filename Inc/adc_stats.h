@@ -0,0 +1,46 @@
+/*
+ * adc_stats.h
+ *
+ * ADC statistics of the StromPi3
+ *
+ * Every filtered ADC-Value of the DMA half-buffers (see filterADCSamples in main.c) is added
+ * to the 1-second statistics of its channel. The completed seconds are combined into the
+ * 1-minute statistics and the completed minutes into the 1-hour statistics, so every
+ * ADC-Value costs only one compare, add and multiply per channel.
+ * The windows are consecutive (tumbling): adc_stats holds the last completed window of every length.
+ *
+ * The statistics are kept in raw ADC-Values and converted into millivolts by the serial console
+ * ("adc-stats" and "stats-rpi" commands).
+ * The 1-minute and 1-hour mean and standard deviation are weighting every second equally.
+ * RAM: 120 bytes for adc_stats and 200 bytes for the accumulators of the 5 channels,
+ * which share their counters.
+ */
+
+#ifndef __ADC_STATS_H__
+#define __ADC_STATS_H__
+
+#include <stdint.h>
+#include "main.h"
+
+#define ADC_STATS_SECOND 0
+#define ADC_STATS_MINUTE 1
+#define ADC_STATS_HOUR 2
+#define ADC_STATS_WINDOWS 3
+
+typedef struct
+{
+	uint16_t min;
+	uint16_t max;
+	uint16_t mean;
+	uint16_t stddev;
+} ADCStat_t;
+
+/*** Last completed window [ADC_STATS_SECOND..ADC_STATS_HOUR][channel] ***/
+extern ADCStat_t adc_stats[ADC_STATS_WINDOWS][adcChannels];
+
+/*** Set, when the window has been completed at least once ***/
+extern uint8_t adc_stats_valid[ADC_STATS_WINDOWS];
+
+void ADCStats_Update(const uint16_t *value);
+
+#endif /* __ADC_STATS_H__ */
@@ -0,0 +1,50 @@
+/*
+ * capture.h
+ *
+ * Waveform capture of the StromPi3
+ *
+ * Like the single-shot mode of a scope, the filtered ADC-Values of the DMA half-buffers
+ * (see filterADCSamples in main.c) are continuously written into a ring buffer.
+ * When the ADC-Watchdog detects a powerfailure, CAPTURE_POST further values are recorded
+ * and then the buffer is frozen, so it holds the last CAPTURE_PRE values before the trigger
+ * and the CAPTURE_POST values after it, until it is read out and re-armed through the
+ * "capture" command of the serial console.
+ *
+ * The 4KB RAM of the STM32F031 only allows to keep the two monitored inputs (Wide and mUSB,
+ * see capture_channel) with the upper 8 bits of the ADC-Values: the buffer takes
+ * CAPTURE_CHANNELS * (CAPTURE_PRE + CAPTURE_POST) = 80 bytes.
+ */
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <stdint.h>
+
+#define CAPTURE_CHANNELS 2
+#define CAPTURE_PRE 16
+#define CAPTURE_POST 24
+#define CAPTURE_LENGTH (CAPTURE_PRE + CAPTURE_POST)
+#define CAPTURE_SHIFT 4
+
+#define CAPTURE_ARMED 0
+#define CAPTURE_TRIGGERED 1
+#define CAPTURE_FROZEN 2
+
+extern volatile uint8_t capture_state;
+
+/*** ADC channel (index of rawValue) of every capture channel ***/
+extern const uint8_t capture_channel[CAPTURE_CHANNELS];
+
+/*** Number of values before the trigger (less than CAPTURE_PRE, if the trigger came early after arming) ***/
+extern uint8_t capture_pre_count;
+
+/*** TIM2 timestamps in microseconds of the trigger and of the last value ***/
+extern uint32_t capture_trigger_time;
+extern uint32_t capture_end_time;
+
+void Capture_Sample(const uint16_t *value);
+void Capture_Trigger(void);
+void Capture_Arm(void);
+void Capture_Get(uint16_t index, uint16_t *value);
+
+#endif /* __CAPTURE_H__ */
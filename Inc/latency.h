@@ -0,0 +1,66 @@
+/*
+ * latency.h
+ *
+ * Failover latency instrumentation of the StromPi3
+ *
+ * TIM2 is running as a free running 32-bit counter with 1MHz, so every
+ * read of its counter is a timestamp in microseconds.
+ * The ADC-Watchdog interrupt stamps its entry, and the time until the PowerPath
+ * has been switched and until the main Task has processed the powerfailure
+ * is collected into the statistics below, which can be read out
+ * through the "failover-latency" command of the serial console.
+ */
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <stdint.h>
+#include "stm32f0xx_hal.h"
+
+/*** Number of histogram bins
+ * Bin 0 counts latencies of 0us, bin n counts latencies from 4^(n-1)us up to 4^n - 1us,
+ * the last bin also counts everything above (4096us) ***/
+#define LATENCY_HIST_BINS 8
+
+typedef struct
+{
+	uint32_t min;
+	uint32_t max;
+	uint32_t sum;
+	uint32_t count;
+	uint16_t hist[LATENCY_HIST_BINS];
+} LatencyStat_t;
+
+/*** Actual timestamp in microseconds ***/
+#define Latency_Now() (TIM2->CNT)
+
+/*** Timestamp of the last ADC-Watchdog interrupt entry ***/
+extern volatile uint32_t latency_awd_timestamp;
+
+/*** Timestamp of the switched PowerPath ***/
+extern volatile uint32_t latency_switch_timestamp;
+
+/*** Set when a powerfailure has been switched and the main Task hasn't processed it yet ***/
+extern volatile uint8_t latency_task_pending;
+
+/*** ADC-Watchdog interrupt entry -> PowerPath GPIO write ***/
+extern LatencyStat_t latency_switch;
+
+/*** ADC-Watchdog interrupt entry -> processing of the powerfailure in the main Task ***/
+extern LatencyStat_t latency_task;
+
+/*** Time-to-protection at boot, when the ADC-Watchdog has been armed by startProtection() in main():
+ * HAL tick in milliseconds since HAL_Init() right after the reset and
+ * TIM2 timestamp in microseconds (TIM2 is started after the clock and RTC configuration) ***/
+extern uint32_t latency_boot_tick;
+extern uint32_t latency_boot_timestamp;
+
+/*** Execution time of the main loop and deviation of its start from loop_period ***/
+extern LatencyStat_t latency_loop_execution;
+extern LatencyStat_t latency_loop_jitter;
+
+void Latency_Record(LatencyStat_t *stat, uint32_t us);
+void Latency_Reset(void);
+void Latency_ResetLoop(void);
+
+#endif /* __LATENCY_H__ */
@@ -92,17 +92,73 @@
 uint16_t rawValue[5];
 uint16_t measuredValue[5];
 
+/*** ADC DMA double buffer
+ * The DMA is writing adcOversampling scans of the 5 ADC channels into each half of adcDMABuffer.
+ * When a half is completed, its scans are averaged per channel into rawValue (filterADCSamples in main.c),
+ * while the DMA is filling the other half.
+ * adcOversampling has to be a power of two, so the averaging is only a shift ***/
+#define adcChannels 5
+#define adcOversampling 8
+#define adcDMABufferSize (2 * adcOversampling * adcChannels)
+
+uint16_t adcDMABuffer[adcDMABufferSize];
+
+/*** ADC conversion
+ * updateMeasuredValues() converts rawValue into millivolts in measuredValue (measuredValue[4] is VDD).
+ * The per-channel scale factors (millivolts per LSB as fixed-point number with adcScaleShift fractional bits)
+ * are only recomputed when the filtered VREFINT value changes, so every conversion is one multiply and shift ***/
+#define VREFINT_CAL (*((unsigned short*) 0x1FFFF7BA))
+#define adcScaleShift 15
+#define adcRatioShift 12
+
+void updateMeasuredValues(void);
+uint16_t convertADCValue(uint8_t channel, uint16_t raw);
+void benchmarkADCConversion(uint32_t *cycles);
+
 void configureAWD_Wide(void);
 void configureAWD_USB(void);
+void configureAWD_PowerBack(void);
+void armPowerBackWatchdog(void);
+
+/*** ADC-Watchdog window
+ * awdWindowFail monitors the primary source for a powerfailure (fail threshold up to 4095),
+ * awdWindowPowerBack monitors the primary source after a failover for its return (0 up to the restore threshold) ***/
+#define awdWindowFail 0
+#define awdWindowPowerBack 1
+
+/*** Margin of the TIM16 power-back debounce in milliseconds ***/
+#define powerBackDebounceMargin 2
+
+volatile uint8_t awd_window;
+uint16_t powerback_irq_counter;
+
+/*** Events of the main Task
+ * They are posted as bits of the task notification value and wake up the main Task immediately:
+ * mainEventPowerFail by the ADC-Watchdog failover, mainEventPowerBack by the debounced power-back interrupt,
+ * mainEventShutdown by the serial console (poweroff command),
+ * mainEventArmPowerBack by the ADC-Watchdog failover for re-arming the ADC-Watchdog with the power-back window,
+ * mainEventReconfigure by a configuration change of the console task for reprogramming the ADC and its Watchdog,
+ * mainEventAlarm by the RTC Alarm A at every full minute ***/
+#define mainEventPowerFail (1UL << 0)
+#define mainEventPowerBack (1UL << 1)
+#define mainEventShutdown (1UL << 2)
+#define mainEventArmPowerBack (1UL << 3)
+#define mainEventReconfigure (1UL << 4)
+#define mainEventAlarm (1UL << 5)
+
+void notifyMainTask(uint32_t event);
 
 void Power_Wide(void);
 void Power_USB(void);
 void Power_Bat(void);
 void Power_Off(void);
+void Power_Source(uint8_t source);
 void ShutdownRPi(void);
 void PowerfailWarning(void);
 void PowerBack(void);
 void Alarm_Handler(void);
+void Alarm_PowerOn(void);
+void Alarm_PowerOff(void);
 void initialCheck(void);
 void Config_Reset_Pin_Input(void);
 void Config_Reset_Pin_Output(void);
@@ -112,6 +168,74 @@ void Config_Reset_Pin_Output(void);
 #define minBatConnect  10
 #define minBat 2500
 
+/*** Failover hysteresis
+ * The primary source fails over, when it drops under its fail threshold (ADC-Watchdog),
+ * but it is only restored, when it has been above its restore threshold for restore_stable_time milliseconds.
+ * minWide and minUSB are the default fail thresholds, the thresholds are raw ADC-Values ***/
+#define minWide_restore_default 400
+#define minUSB_restore_default 1900
+#define restore_stable_time_default 1000
+/*** The stable time and the margin of the power-back debounce have to fit the 16-bit TIM16 ***/
+#define restore_stable_time_max (0xFFFF - powerBackDebounceMargin)
+
+uint16_t minWide_fail;
+uint16_t minWide_restore;
+uint16_t minUSB_fail;
+uint16_t minUSB_restore;
+uint16_t restore_stable_time;
+
+uint8_t restoreStable_Wide(void);
+uint8_t restoreStable_USB(void);
+void validateConfig(void);
+
+/*** Predictive brown-out detection
+ * The slope of the primary source is estimated over the last slopeWindow filtered ADC-Values.
+ * When it drops faster than slope_rate (ADC-Value per millisecond), the backup source is
+ * pre-armed (slope_mode 1) or the PowerPath is switched before the ADC-Watchdog threshold is reached (slope_mode 2).
+ * A history, which has taken longer than twice the time of its half-buffers at the scan rate (adc_rate),
+ * has a gap and isn't used. In the continuous mode the limit is slopeMaxTimeContinuous (in microseconds) ***/
+#define slopeWindow 4
+#define slopeMaxTimeContinuous 1000000
+#define slope_mode_default 0
+#define slope_rate_default 20
+
+uint8_t slope_mode;
+uint16_t slope_rate;
+
+uint16_t slope_prearm_counter;
+uint16_t slope_failover_counter;
+uint16_t threshold_failover_counter;
+uint8_t slope_failover_flag;
+
+uint16_t slope_peak_drop;
+uint32_t slope_peak_time;
+
+void resetSlopeCounters(void);
+
+/*** ADC acquisition mode
+ * With adc_rate 0 the ADC is converting continuously. Otherwise TIM3 triggers (TRGO) a scan of all channels
+ * adc_rate times per second, and with adc_autooff the ADC is powered off between the scans.
+ * A lower rate reduces the quiescent current, but the ADC-Watchdog, which stays armed on the primary source,
+ * can only detect a powerfailure with the next scan ***/
+#define adcTriggerClock 10000
+#define adc_rate_max 1000
+
+uint16_t adc_rate;
+uint8_t adc_autooff;
+
+void configureADCMode(void);
+
+/*** Stack of the main task (StartDefaultTask) in words, it is allocated statically ***/
+#define mainTaskStackSize 64
+
+/*** Period of the main loop in milliseconds
+ * The main loop runs at a fixed rate (vTaskDelayUntil) with loop_period, which has to be a divisor of 1000,
+ * so the timers of the main loop (shutdown-timer, power-on button, ...) still count full seconds ***/
+#define loop_period_default 1000
+#define loop_period_min 10
+
+uint16_t loop_period;
+
 uint8_t poweroff_flag;
 uint8_t interval_off_flag;
 
@@ -203,9 +327,42 @@ uint8_t serialLess_communication_on_flag;
 
 void reconfigureWatchdog();
 
-#define configMax 29
+/*** Fast failover
+ * When enabled, the ADC1 interrupt vector switches the PowerPath with a single store
+ * of the precomputed GPIOA BSRR word failover_bsrr, before the HAL processes the interrupt.
+ * updateFailoverPath() has to be called whenever modus, threeStageMode or powersave_enable changes ***/
+#define fastFailover 1
+
+volatile uint32_t failover_bsrr;
+
+void updateFailoverPath(void);
+
+/*** Interrupt priorities (0 is the highest, see MX_NVIC_Init)
+ *  0: ADC1 - only switches the PowerPath with failover_bsrr and pends ADC_Deferred_IRQn for the HAL processing
+ *  1: TIM14 - HAL timebase (TICK_INT_PRIORITY), only counts the HAL tick, so the HAL timeouts run in the interrupts below
+ *  3: ADC_Deferred_IRQn, DMA1 Channel 1, DMA1 Channel 2 and 3, USART1, TIM16, RTC, SysTick and PendSV, which may call the FreeRTOS API
+ *     (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY)
+ * The Cortex-M0 port of FreeRTOS masks all interrupts in its critical sections, so these have to be kept short.
+ * ADC_Deferred_IRQn is the vector of the unused TIM17, which is only pended by software ***/
+#define ADC_Deferred_IRQn TIM17_IRQn
+
+/*** Tickless idle
+ * When all tasks are blocked, the idle task suppresses the FreeRTOS tick and the core waits in the SLEEP mode
+ * for the next interrupt, the HAL tick is suspended meanwhile (see PreSleepProcessing in freertos.c). The times asleep and awake are summed up in microseconds
+ * and both are halved, when one of them reaches lowpowerAgingLimit, so the residency follows the recent operation ***/
+#define lowpowerAgingLimit 0x80000000UL
+
+uint32_t lowpower_sleep_time;
+uint32_t lowpower_awake_time;
+uint32_t lowpower_sleep_counter;
+
+void PreSleepProcessing(uint32_t *ulExpectedIdleTime);
+void PostSleepProcessing(uint32_t *ulExpectedIdleTime);
+
+#define configMax 39
 
-uint32_t configParamters[configMax];
+/*** The configuration variables have at most 16 bits, so do the parameters ***/
+uint16_t configParamters[configMax];
 
 #define chargingOffset 90
 
@@ -237,11 +394,26 @@ uint32_t configParamters[configMax];
 #define wakeup_time_enable_FlashAdress 0x8007D90
 #define wakeup_time_FlashAdress 0x8007DA0
 #define wakeupweekend_enable_FlashAdress 0x8007DB0
+#define minUSB_fail_FlashAdress 0x8007DC0
+#define minUSB_restore_FlashAdress 0x8007DD0
+#define minWide_fail_FlashAdress 0x8007DE0
+#define minWide_restore_FlashAdress 0x8007DF0
+#define restore_stable_time_FlashAdress 0x8007E00
+#define slope_mode_FlashAdress 0x8007E10
+#define slope_rate_FlashAdress 0x8007E20
+#define adc_rate_FlashAdress 0x8007E30
+#define adc_autooff_FlashAdress 0x8007E40
+#define loop_period_FlashAdress 0x8007E50
+
+/*** Schedule table (see schedule.h), SCHEDULE_ENTRIES of 8 bytes at the end of the configuration page ***/
+#define schedule_FlashAdress 0x8007F00
 
 void flashConfig(void);
 void flashValue(uint32_t address, uint32_t data);
 
 void updateConfig(void);
+void setConfig(uint8_t index, uint32_t value);
+uint8_t setConfigAll(const uint8_t *value);
 
 /* USER CODE END Private defines */
 
@@ -0,0 +1,43 @@
+/*
+ * power_arbiter.h
+ *
+ * Arbitration of the PowerPath of the StromPi3
+ *
+ * The mode (modus) defines the primary and the backup source:
+ *
+ *  1: mUSB (primary) -> Wide (secondary)
+ *  2: Wide (primary) -> mUSB (secondary)
+ *  3: mUSB (primary) -> Battery (secondary)
+ *  4: Wide (primary) -> Battery (secondary)
+ *
+ * The source, which powers the Raspberry Pi, is looked up in a table from the mode and the
+ * availability of the sources (stable above their restore threshold). The three-stage-mode
+ * (5: mUSB -> Wide -> Battery, 6: Wide -> mUSB -> Battery) switches between the modes 1..4,
+ * its transitions are looked up in a second table.
+ *
+ * The functions only read their parameters and the constant tables, so they can be called
+ * from the interrupts as well as from the tasks and don't depend on the HAL.
+ */
+
+#ifndef __POWER_ARBITER_H__
+#define __POWER_ARBITER_H__
+
+#include <stdint.h>
+
+/*** Sources, the values are the same as the output_status ***/
+#define powerSourceNone 0
+#define powerSourceUSB 1
+#define powerSourceWide 2
+#define powerSourceBat 3
+
+/*** Availability of the sources (bitmask) ***/
+#define powerAvailable(source) (1U << ((source) - 1))
+#define powerAvailableUSB powerAvailable(powerSourceUSB)
+#define powerAvailableWide powerAvailable(powerSourceWide)
+
+uint8_t PowerArbiter_Select(uint8_t modus, uint8_t available);
+uint8_t PowerArbiter_Primary(uint8_t modus);
+uint8_t PowerArbiter_Backup(uint8_t modus);
+uint8_t PowerArbiter_ThreeStage(uint8_t threeStageMode, uint8_t modus, uint8_t output, uint8_t alive, uint8_t available, uint8_t *reconfigure);
+
+#endif /* __POWER_ARBITER_H__ */
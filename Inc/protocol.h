@@ -0,0 +1,77 @@
+/*
+ * protocol.h
+ *
+ * Binary protocol of the StromPi3
+ *
+ * The scripts of the Raspberry Pi can exchange binary frames with the StromPi3 through the serial console.
+ * The frames are multiplexed with the text console, because a character of the console is never 0x00:
+ *
+ * 		0x00 | COBS-encoded frame | 0x00
+ *
+ * The decoded frame is:
+ *
+ * 		type (1 byte) | seq (1 byte) | data (0..protocolDataMax bytes) | crc (4 bytes)
+ *
+ * - The numbers in data and crc are little endian.
+ * - crc is the standard CRC-32 (like zlib.crc32() in Python) of type, seq and data. It is computed by the CRC unit of the STM32F031.
+ * - Every request is answered by a frame with the type (type | protocolResponse) and the same seq.
+ *   The first data byte of the answer is the result (protocolOk or one of the errors), so the script gets a positive acknowledgement
+ *   and can repeat a request with the same seq, when the answer is missing or has a wrong crc.
+ *
+ * Requests (data of the request -> data of the answer after the result):
+ * - protocolPing: -> protocolVersion, firmware version (characters)
+ * - protocolStatus: -> the values of the command status-rpi (protocolStatusFormat)
+ * - protocolMeasurement: -> measuredValue[0..4] in mV, output_status, batLevel, charging, powerfailure_counter ('<5HBBBH')
+ * - protocolConfigGet: index, count -> index, count values of configParamters ('<B' + count * 'I')
+ * - protocolConfigSet: index, value (uint32) -> index, configParamters[index] (like "set-config index value")
+ * - protocolEvents: 1 or 0 -> turns the event frames on or off
+ * - protocolConfigSetAll: count (configMax-1), the values of the parameters 1 to count (uint16) -> count
+ *   All values are checked before any parameter is changed and the flash is written once (setConfigAll() in main.c),
+ *   protocolErrorRange is followed by the first parameter out of range. A new configuration takes a single frame
+ *   instead of a set-config line per parameter.
+ *
+ * When the event frames are turned on, the StromPi3 sends a frame with the type protocolEvent and an own seq
+ * in addition to the text messages (xxxShutdownRaspberryPixxx etc.), its data is the protocolEvent... code.
+ */
+
+#ifndef __PROTOCOL_H__
+#define __PROTOCOL_H__
+
+#include <stdint.h>
+
+#define protocolVersion 1
+
+/*** Types ***/
+#define protocolPing 0x01
+#define protocolStatus 0x02
+#define protocolMeasurement 0x03
+#define protocolConfigGet 0x04
+#define protocolConfigSet 0x05
+#define protocolEvents 0x06
+#define protocolConfigSetAll 0x07
+#define protocolEvent 0x10
+#define protocolResponse 0x80
+
+/*** Results ***/
+#define protocolOk 0
+#define protocolErrorCrc 1
+#define protocolErrorType 2
+#define protocolErrorLength 3
+#define protocolErrorRange 4
+
+/*** Codes of the event frames ***/
+#define protocolEventShutdown 1
+#define protocolEventPowerfail 2
+#define protocolEventPowerBack 3
+
+/*** Layout of the answer to protocolStatus (Python struct), followed by the firmware version ***/
+#define protocolStatusFormat "<7B12BH3B2H4BH3BHB4HBH"
+
+/*** Longest data of an answer and of a request (protocolConfigSetAll) ***/
+#define protocolDataMax 64
+#define protocolRequestMax 80
+
+uint8_t Protocol_Receive(uint8_t data);
+void Protocol_Event(uint8_t code);
+
+#endif /* __PROTOCOL_H__ */
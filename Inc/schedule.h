@@ -0,0 +1,66 @@
+/*
+ * schedule.h
+ *
+ * Schedule table of the StromPi3
+ *
+ * In addition to the single wake and poweroff alarm of the configuration, up to SCHEDULE_ENTRIES
+ * cron-like entries can be stored in the last part of the configuration flash page (schedule_FlashAdress).
+ * An entry fires, when its minute and hour match (or are scheduleEvery) and the weekday and the day of the month
+ * are both set in its masks, so e.g. different schedules for the working days and the weekend can be combined.
+ *
+ * The time of the next firing entry is precomputed as a minute stamp (minutes since 2000-01-01),
+ * so the Alarm_Handler() only compares it once per minute. The entries are only evaluated again,
+ * when the stamp has been reached, when the table has been changed or when the RTC has been set.
+ *
+ * The actions are:
+ * - scheduleWake: turns the Raspberry Pi on (like the wake alarm)
+ * - scheduleShutdown: shuts the Raspberry Pi down (like the poweroff alarm)
+ * - scheduleInterval: turns the Raspberry Pi on and shuts it down after alarmIntervalMinOn minutes
+ */
+
+#ifndef __SCHEDULE_H__
+#define __SCHEDULE_H__
+
+#include <stdint.h>
+#include "stm32f0xx_hal.h"
+
+#define SCHEDULE_ENTRIES 8
+
+/*** Value of minute or hour, which matches every minute or hour ***/
+#define scheduleEvery 0xFF
+
+#define scheduleWeekdaysAll 0x7F
+#define scheduleDaysAll 0x7FFFFFFF
+
+/*** Actions, an erased entry (0xFF) is empty ***/
+#define scheduleOff 0
+#define scheduleWake 1
+#define scheduleShutdown 2
+#define scheduleInterval 3
+#define scheduleEmpty 0xFF
+
+/*** Minute stamp, if no entry will fire ***/
+#define scheduleNever 0xFFFFFFFF
+
+/*** An entry fills two flash words ***/
+typedef struct
+{
+	uint8_t minute; /*** 0..59 or scheduleEvery ***/
+	uint8_t hour; /*** 0..23 or scheduleEvery ***/
+	uint8_t weekdays; /*** Bit 0: Monday .. Bit 6: Sunday ***/
+	uint8_t action;
+	uint32_t days; /*** Bit 0: 1st .. Bit 30: 31st day of the month ***/
+} ScheduleEntry_t;
+
+/*** Minute stamp of the next firing entry ***/
+extern uint32_t schedule_next;
+
+void Schedule_Reschedule(void);
+void Schedule_Handler(const RTC_TimeTypeDef *time, const RTC_DateTypeDef *date);
+const ScheduleEntry_t *Schedule_Get(uint8_t index);
+void Schedule_Set(uint8_t index, const ScheduleEntry_t *entry);
+void Schedule_Copy(void);
+void Schedule_Flash(void);
+uint32_t Schedule_Now(void);
+
+#endif /* __SCHEDULE_H__ */
@@ -0,0 +1,25 @@
+/*
+ * slope.h
+ *
+ * Slope comparisons of the predictive brown-out detection of the StromPi3
+ *
+ * The slope estimator (see updateSlopeEstimator in main.c) compares a drop of ADC-Values
+ * over a time in microseconds against slope_rate (ADC-Value per millisecond) and against the
+ * steepest slope seen so far. The comparisons are done without a division by multiplying crosswise.
+ *
+ * At a low adc_rate the history covers up to 64 seconds, so a product of a 12-bit ADC-Value
+ * and a time in microseconds doesn't fit into 32 bits. The products are calculated with 64 bits,
+ * the Cortex-M0 needs a few more cycles for them once per DMA half-buffer.
+ *
+ * The functions don't depend on the HAL, so they are checked on the host (see Test/test_slope.c).
+ */
+
+#ifndef __SLOPE_H__
+#define __SLOPE_H__
+
+#include <stdint.h>
+
+uint8_t Slope_Exceeds(uint16_t drop, uint32_t time, uint16_t rate);
+uint8_t Slope_Steeper(uint16_t drop, uint32_t time, uint16_t peak_drop, uint32_t peak_time);
+
+#endif /* __SLOPE_H__ */
@@ -50,10 +50,14 @@
 void NMI_Handler(void);
 void HardFault_Handler(void);
 void SysTick_Handler(void);
+void RTC_IRQHandler(void);
 void DMA1_Channel1_IRQHandler(void);
+void DMA1_Channel2_3_IRQHandler(void);
 void ADC1_IRQHandler(void);
 void TIM14_IRQHandler(void);
+void TIM16_IRQHandler(void);
 void USART1_IRQHandler(void);
+void TIM17_IRQHandler(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,54 @@
+/*
+ * task_stats.h
+ *
+ * Runtime task statistics of the StromPi3
+ *
+ * FreeRTOS accumulates the run time of every task (configGENERATE_RUN_TIME_STATS) with the
+ * free running 1MHz counter of TIM2 (see latency.h). The time the idle task spends in the
+ * SLEEP mode (tickless idle) is counted to the idle task as well, so its share is the idle time of the core.
+ *
+ * The interrupts of the ADC, the DMA (ADC and USART1 channels), USART1 and TIM14 (HAL timebase) are counted in their handlers (stm32f0xx_it.c).
+ *
+ * The 32-bit counters wrap after about 71 minutes, so TaskStats_Sample() returns the CPU share and the
+ * interrupt counts of the interval since its last call, which is read out through the
+ * "task-stats" command of the serial console.
+ */
+
+#ifndef __TASK_STATS_H__
+#define __TASK_STATS_H__
+
+#include <stdint.h>
+
+/*** Main task, console task and idle task ***/
+#define TASK_STATS_TASKS 3
+
+#define TASK_STATS_ISR_ADC 0
+#define TASK_STATS_ISR_DMA 1
+#define TASK_STATS_ISR_USART1 2
+#define TASK_STATS_ISR_TIM14 3
+#define TASK_STATS_ISRS 4
+
+typedef struct
+{
+	const char *name;
+	uint16_t share; /*** CPU share in 0.1% ***/
+	uint16_t stackFree; /*** Stack high water mark in bytes ***/
+} TaskStatsTask_t;
+
+typedef struct
+{
+	uint32_t interval; /*** Microseconds since the last sample ***/
+	uint8_t tasks;
+	TaskStatsTask_t task[TASK_STATS_TASKS];
+	uint16_t idle; /*** CPU share of the idle task in 0.1% ***/
+	uint32_t isr[TASK_STATS_ISRS]; /*** Interrupts since the last sample ***/
+} TaskStats_t;
+
+/*** Every counter is only incremented by its own interrupt ***/
+extern volatile uint32_t task_stats_isr_count[TASK_STATS_ISRS];
+
+#define TaskStats_CountISR(isr) (task_stats_isr_count[isr]++)
+
+void TaskStats_Sample(TaskStats_t *stats);
+
+#endif /* __TASK_STATS_H__ */
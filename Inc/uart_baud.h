@@ -0,0 +1,36 @@
+/*
+ * uart_baud.h
+ *
+ * Baudrate negotiation of the serial interface of the StromPi3
+ *
+ * The StromPi3 starts with uartBaudDefault, which the scripts of the Raspberry Pi expect.
+ * A script can switch to a higher baudrate (e.g. for the capture dump) by the command "set-baud <rate>":
+ * - the answer is sent with the actual baudrate, then the StromPi3 switches to the new one
+ * - the script has to open the serial interface with the new baudrate and to send "set-baud ok" within uartBaudConfirmTime
+ * - otherwise the StromPi3 returns to uartBaudDefault, so it can't get lost at a baudrate the Raspberry Pi doesn't use
+ *
+ * A confirmed baudrate is kept until nothing has been received for uartBaudIdleTime
+ * or until the Raspberry Pi is shut down or powered off, then the StromPi3 returns to uartBaudDefault.
+ *
+ * The negotiated baudrate isn't stored in the flash, so the StromPi3 always starts with uartBaudDefault
+ * and a shutdown script, which has been started at boot, receives the messages.
+ */
+
+#ifndef __UART_BAUD_H__
+#define __UART_BAUD_H__
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+#define uartBaudDefault 38400
+#define uartBaudConfirmTime 3000
+#define uartBaudIdleTime 30000
+
+uint8_t UartBaud_Request(uint32_t rate);
+uint8_t UartBaud_Confirm(void);
+uint32_t UartBaud_Rate(void);
+void UartBaud_Received(void);
+void UartBaud_Default(void);
+TickType_t UartBaud_Process(void);
+
+#endif /* __UART_BAUD_H__ */
@@ -0,0 +1,33 @@
+/*
+ * uart_tx.h
+ *
+ * Transmit queue of the serial interface of the StromPi3
+ *
+ * All output of USART1 is sent by the DMA (Channel 2) from two lanes:
+ * - the event lane holds up to uartTxEvents messages (shutdown, powerfail, powerback),
+ *   which are sent from their constant buffers without a copy
+ * - the bulk lane sends the output of the serial console from the buffer of the caller without a copy,
+ *   UartTx_Bulk() returns after the data have been sent (there is no RAM for a ring buffer)
+ *
+ * The DMA channel is driven through its registers and the next transfer is started by its transfer complete interrupt. An event message always goes
+ * before the bulk lane and the bulk lane is sent in pieces of at most uartTxBulkPiece bytes (about 8ms at 38400 baud),
+ * so an event message never waits behind a long output of the console.
+ */
+
+#ifndef __UART_TX_H__
+#define __UART_TX_H__
+
+#include <stdint.h>
+
+#define uartTxEvents 4
+#define uartTxBulkPiece 32
+
+void UartTx_Event(const uint8_t *message, uint16_t length);
+void UartTx_Bulk(const uint8_t *data, uint16_t length);
+void UartTx_Suspend(void);
+void UartTx_Resume(void);
+void UartTx_HoldEvents(void);
+void UartTx_ReleaseEvents(void);
+void UartTx_IRQHandler(void);
+
+#endif /* __UART_TX_H__ */
@@ -61,12 +61,45 @@ one of the application files:
 	#define configAPPLICATION_PROVIDES_cOutputBuffer 0
 #endif
 
+/* If the commands can't be registered at run time (for example because
+configSUPPORT_DYNAMIC_ALLOCATION is 0), then set
+configAPPLICATION_PROVIDES_COMMAND_TABLE to 1 in FreeRTOSConfig.h, then define
+a NULL terminated table with the following name in one of the application
+files, so the commands are kept in flash:
+	const CLI_Command_Definition_t * const pxCLICommandTable[] = { &xCommand, NULL };
+The help command is always listed before the commands of the table.
+*/
+#ifndef configAPPLICATION_PROVIDES_COMMAND_TABLE
+	#define configAPPLICATION_PROVIDES_COMMAND_TABLE 0
+#endif
+
+#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 0 )
+
 typedef struct xCOMMAND_INPUT_LIST
 {
 	const CLI_Command_Definition_t *pxCommandLineDefinition;
 	struct xCOMMAND_INPUT_LIST *pxNext;
 } CLI_Definition_List_Item_t;
 
+#define cliDEFINITION( pxCommand ) ( ( pxCommand )->pxCommandLineDefinition )
+
+#else
+
+/* The commands are referenced directly from the table. */
+typedef const CLI_Command_Definition_t CLI_Definition_List_Item_t;
+
+#define cliDEFINITION( pxCommand ) ( pxCommand )
+
+extern const CLI_Command_Definition_t * const pxCLICommandTable[];
+
+/*
+ * Return the command with the index uxIndex (0 is the help command) or NULL
+ * after the end of the table.
+ */
+static const CLI_Command_Definition_t *prvGetCommand( UBaseType_t uxIndex );
+
+#endif /* configAPPLICATION_PROVIDES_COMMAND_TABLE */
+
 /*
  * The callback function that is executed when "help" is entered.  This is the
  * only default command that is always present.
@@ -88,6 +121,7 @@ static const CLI_Command_Definition_t xHelpCommand =
 	0
 };
 
+#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 0 )
 /* The definition of the list of commands.  Commands that are registered are
 added to this list. */
 static CLI_Definition_List_Item_t xRegisteredCommands =
@@ -95,6 +129,7 @@ static CLI_Definition_List_Item_t xRegisteredCommands =
 	&xHelpCommand,	/* The first command in the list is always the help command, defined in this file. */
 	NULL			/* The next pointer is initialised to NULL, as there are no other registered commands yet. */
 };
+#endif
 
 /* A buffer into which command outputs can be written is declared here, rather
 than in the command console implementation, to allow multiple command consoles
@@ -117,6 +152,8 @@ buffer needs to be placed at a fixed address (rather than by the linker). */
 
 /*-----------------------------------------------------------*/
 
+#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 0 )
+
 BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister )
 {
 static CLI_Definition_List_Item_t *pxLastCommandInList = &xRegisteredCommands;
@@ -156,6 +193,20 @@ BaseType_t xReturn = pdFAIL;
 
 	return xReturn;
 }
+
+#else
+
+static const CLI_Command_Definition_t *prvGetCommand( UBaseType_t uxIndex )
+{
+	if( uxIndex == 0 )
+	{
+		return &xHelpCommand;
+	}
+
+	return pxCLICommandTable[ uxIndex - 1 ];
+}
+
+#endif /* configAPPLICATION_PROVIDES_COMMAND_TABLE */
 /*-----------------------------------------------------------*/
 
 BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  )
@@ -164,6 +215,9 @@ static const CLI_Definition_List_Item_t *pxCommand = NULL;
 BaseType_t xReturn = pdTRUE;
 const char *pcRegisteredCommandString;
 size_t xCommandStringLength;
+#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 1 )
+UBaseType_t uxIndex;
+#endif
 
 	/* Note:  This function is not re-entrant.  It must not be called from more
 	thank one task. */
@@ -171,9 +225,13 @@ size_t xCommandStringLength;
 	if( pxCommand == NULL )
 	{
 		/* Search for the command string in the list of registered commands. */
+		#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 0 )
 		for( pxCommand = &xRegisteredCommands; pxCommand != NULL; pxCommand = pxCommand->pxNext )
+		#else
+		for( uxIndex = 0; ( pxCommand = prvGetCommand( uxIndex ) ) != NULL; uxIndex++ )
+		#endif
 		{
-			pcRegisteredCommandString = pxCommand->pxCommandLineDefinition->pcCommand;
+			pcRegisteredCommandString = cliDEFINITION( pxCommand )->pcCommand;
 			xCommandStringLength = strlen( pcRegisteredCommandString );
 
 			/* To ensure the string lengths match exactly, so as not to pick up
@@ -188,9 +246,9 @@ size_t xCommandStringLength;
 					number of parameters.  If cExpectedNumberOfParameters is -1,
 					then there could be a variable number of parameters and no
 					check is made. */
-					if( pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters >= 0 )
+					if( cliDEFINITION( pxCommand )->cExpectedNumberOfParameters >= 0 )
 					{
-						if( prvGetNumberOfParameters( pcCommandInput ) != pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters )
+						if( prvGetNumberOfParameters( pcCommandInput ) != cliDEFINITION( pxCommand )->cExpectedNumberOfParameters )
 						{
 							xReturn = pdFALSE;
 						}
@@ -212,7 +270,7 @@ size_t xCommandStringLength;
 	else if( pxCommand != NULL )
 	{
 		/* Call the callback function that is registered to this command. */
-		xReturn = pxCommand->pxCommandLineDefinition->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
+		xReturn = cliDEFINITION( pxCommand )->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
 
 		/* If xReturn is pdFALSE, then no further strings will be returned
 		after this one, and	pxCommand can be reset to NULL ready to search
@@ -299,29 +357,58 @@ static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, c
 {
 static const CLI_Definition_List_Item_t * pxCommand = NULL;
 BaseType_t xReturn;
+#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 1 )
+static UBaseType_t uxIndex = 0;
+#endif
+static size_t xOffset = 0;
+const char *pcHelpString;
 
 	( void ) pcCommandString;
 
 	if( pxCommand == NULL )
 	{
 		/* Reset the pxCommand pointer back to the start of the list. */
+		#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 0 )
 		pxCommand = &xRegisteredCommands;
+		#else
+		uxIndex = 0;
+		pxCommand = prvGetCommand( uxIndex );
+		#endif
 	}
 
 	/* Return the next command help string, before moving the pointer on to
-	the next command in the list. */
-	strncpy( pcWriteBuffer, pxCommand->pxCommandLineDefinition->pcHelpString, xWriteBufferLen );
-	pxCommand = pxCommand->pxNext;
+	the next command in the list.  A help string longer than the output buffer
+	is returned in pieces, the pointer is only moved on after its last piece. */
+	pcHelpString = cliDEFINITION( pxCommand )->pcHelpString + xOffset;
+	strncpy( pcWriteBuffer, pcHelpString, xWriteBufferLen - 1 );
+	pcWriteBuffer[ xWriteBufferLen - 1 ] = 0x00;
 
-	if( pxCommand == NULL )
+	if( strlen( pcHelpString ) >= xWriteBufferLen )
 	{
-		/* There are no more commands in the list, so there will be no more
-		strings to return after this one and pdFALSE should be returned. */
-		xReturn = pdFALSE;
+		/* The rest of the help string is returned with the next call. */
+		xOffset += xWriteBufferLen - 1;
+		xReturn = pdTRUE;
 	}
 	else
 	{
-		xReturn = pdTRUE;
+		xOffset = 0;
+		#if( configAPPLICATION_PROVIDES_COMMAND_TABLE == 0 )
+		pxCommand = pxCommand->pxNext;
+		#else
+		uxIndex++;
+		pxCommand = prvGetCommand( uxIndex );
+		#endif
+
+		if( pxCommand == NULL )
+		{
+			/* There are no more commands in the list, so there will be no more
+			strings to return after this one and pdFALSE should be returned. */
+			xReturn = pdFALSE;
+		}
+		else
+		{
+			xReturn = pdTRUE;
+		}
 	}
 
 	return xReturn;
@@ -71,6 +71,12 @@ typedef struct xCOMMAND_LINE_INPUT
  */
 BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister );
 
+/*
+ * With configAPPLICATION_PROVIDES_COMMAND_TABLE set to 1 the commands aren't
+ * registered, but listed in the NULL terminated table pxCLICommandTable of the
+ * application (see FreeRTOS_CLI.c).
+ */
+
 /*
  * Runs the command interpreter for the command string "pcCommandInput".  Any
  * output generated by running the command will be placed into pcWriteBuffer.
@@ -0,0 +1,163 @@
+#!/usr/bin/env python
+import serial
+import struct
+import sys
+import zlib
+
+##############################################################################
+# Configuration of the StromPi3 through the binary protocol
+#
+# StromPi3_Config_Binary.py save <file>: writes the configuration into the file
+# StromPi3_Config_Binary.py load <file>: sends the configuration of the file
+#                                        to the StromPi3 in a single frame
+#
+# The file has a line "<parameter> <value>" for the parameters 1 to 38
+# (the numbers of set-config). All values are checked by the StromPi3 before
+# any parameter is changed, then they are written to its flash at once.
+#
+# The frames are COBS-encoded and enclosed by 0x00 (see protocol.h of the
+# firmware), so they can be sent while the text console is running.
+# A decoded frame is: type, seq, data, CRC-32 (little endian)
+# Every request is answered with (type | 0x80), the same seq and a result byte,
+# a missing or damaged answer is requested again with the same seq.
+##############################################################################
+retries = 3
+parameters = 38
+##############################################################################
+
+PING = 0x01
+STATUS = 0x02
+MEASUREMENT = 0x03
+CONFIG_GET = 0x04
+CONFIG_SET = 0x05
+EVENTS = 0x06
+CONFIG_SET_ALL = 0x07
+EVENT = 0x10
+RESPONSE = 0x80
+
+serial_port = serial.Serial()
+
+serial_port.baudrate = 38400
+serial_port.port = '/dev/serial0'
+serial_port.timeout = 1
+serial_port.bytesize = 8
+serial_port.stopbits = 1
+serial_port.parity = serial.PARITY_NONE
+
+if serial_port.isOpen(): serial_port.close()
+serial_port.open()
+
+seq = 0
+
+def cobs_encode(data):
+    encoded = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            encoded.append(len(block) + 1)
+            encoded += block
+            block = bytearray()
+        else:
+            block.append(byte)
+            if len(block) == 254:
+                encoded.append(255)
+                encoded += block
+                block = bytearray()
+    encoded.append(len(block) + 1)
+    encoded += block
+    return bytes(encoded)
+
+def cobs_decode(data):
+    decoded = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        if code == 0 or index + code > len(data):
+            return None
+        decoded += data[index + 1:index + code]
+        index += code
+        if code < 255 and index < len(data):
+            decoded.append(0)
+    return bytes(decoded)
+
+def read_frame():
+    # Text of the console is skipped up to the next frame
+    while True:
+        byte = serial_port.read(1)
+        if not byte:
+            return None
+        if byte == b'\x00':
+            break
+    frame = bytearray()
+    while True:
+        byte = serial_port.read(1)
+        if not byte:
+            return None
+        if byte == b'\x00':
+            if frame:
+                break
+            continue
+        frame += byte
+    frame = cobs_decode(bytes(frame))
+    if frame is None or len(frame) < 6:
+        return None
+    if zlib.crc32(frame[:-4]) & 0xFFFFFFFF != struct.unpack('<I', frame[-4:])[0]:
+        return None
+    return frame[0], frame[1], frame[2:-4]
+
+def request(frame_type, data=b''):
+    global seq
+    seq = (seq + 1) & 0xFF
+    frame = bytes([frame_type, seq]) + data
+    frame += struct.pack('<I', zlib.crc32(frame) & 0xFFFFFFFF)
+    for attempt in range(retries):
+        serial_port.write(b'\x00' + cobs_encode(frame) + b'\x00')
+        while True:
+            answer = read_frame()
+            if answer is None:
+                break
+            answer_type, answer_seq, answer_data = answer
+            if answer_type == frame_type | RESPONSE and answer_seq == seq:
+                if answer_data[0] != 0:
+                    raise IOError('StromPi3 answered with error %d' % answer_data[0])
+                return answer_data[1:]
+    raise IOError('No answer of the StromPi3')
+
+def config_get_all():
+    values = []
+    while len(values) < parameters:
+        count = min(15, parameters - len(values))
+        data = request(CONFIG_GET, bytes([len(values) + 1, count]))
+        values += struct.unpack('<%dI' % count, data[1:])
+    return values
+
+def config_set_all(values):
+    data = struct.pack('<B%dH' % parameters, parameters, *values)
+    try:
+        request(CONFIG_SET_ALL, data)
+    except IOError as error:
+        raise IOError('%s (parameter out of range or wrong number of parameters)' % error)
+
+if len(sys.argv) != 3 or sys.argv[1] not in ('save', 'load'):
+    print('Usage: %s save|load <file>' % sys.argv[0])
+    sys.exit(1)
+
+serial_port.reset_input_buffer()
+
+if sys.argv[1] == 'save':
+    values = config_get_all()
+    with open(sys.argv[2], 'w') as config_file:
+        for index, value in enumerate(values):
+            config_file.write('%d %d\n' % (index + 1, value))
+    print('%d parameters saved' % len(values))
+else:
+    values = config_get_all()
+    with open(sys.argv[2]) as config_file:
+        for line in config_file:
+            fields = line.split()
+            if len(fields) == 2 and 1 <= int(fields[0]) <= parameters:
+                values[int(fields[0]) - 1] = int(fields[1])
+    config_set_all(values)
+    print('%d parameters loaded' % parameters)
+
+serial_port.close()
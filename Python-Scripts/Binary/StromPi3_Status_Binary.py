@@ -0,0 +1,150 @@
+#!/usr/bin/env python
+import serial
+import struct
+import zlib
+
+##############################################################################
+# Status of the StromPi3 through the binary protocol
+#
+# The frames are COBS-encoded and enclosed by 0x00 (see protocol.h of the
+# firmware), so they can be sent while the text console is running.
+# A decoded frame is: type, seq, data, CRC-32 (little endian)
+# Every request is answered with (type | 0x80), the same seq and a result byte,
+# a missing or damaged answer is requested again with the same seq.
+##############################################################################
+retries = 3
+##############################################################################
+
+PING = 0x01
+STATUS = 0x02
+MEASUREMENT = 0x03
+CONFIG_GET = 0x04
+CONFIG_SET = 0x05
+EVENTS = 0x06
+EVENT = 0x10
+RESPONSE = 0x80
+
+STATUS_FORMAT = '<7B12BH3B2H4BH3BHB4HBH'
+STATUS_FIELDS = ('hours', 'minutes', 'seconds', 'year', 'month', 'date', 'weekday',
+                 'mode', 'alarm_enable', 'alarm_mode', 'alarm_hour', 'alarm_min', 'alarm_day',
+                 'alarm_month', 'alarm_weekday', 'alarmPoweroff', 'alarm_hour_off', 'alarm_min_off',
+                 'shutdown_enable', 'shutdown_time', 'warning_enable', 'serialLessMode', 'alarmInterval',
+                 'alarmIntervalMinOn', 'alarmIntervalMinOff', 'batLevel_shutdown', 'batLevel', 'charging',
+                 'powerOnButton_enable', 'powerOnButton_time', 'powersave_enable', 'poweroff_enable',
+                 'wakeup_time_enable', 'wakeup_time', 'wakeupweekend_enable', 'wide_range_volt', 'battery_volt',
+                 'mUSB_volt', 'output_volt', 'output_status', 'powerfailure_counter')
+
+serial_port = serial.Serial()
+
+serial_port.baudrate = 38400
+serial_port.port = '/dev/serial0'
+serial_port.timeout = 1
+serial_port.bytesize = 8
+serial_port.stopbits = 1
+serial_port.parity = serial.PARITY_NONE
+
+if serial_port.isOpen(): serial_port.close()
+serial_port.open()
+
+seq = 0
+
+def cobs_encode(data):
+    encoded = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            encoded.append(len(block) + 1)
+            encoded += block
+            block = bytearray()
+        else:
+            block.append(byte)
+            if len(block) == 254:
+                encoded.append(255)
+                encoded += block
+                block = bytearray()
+    encoded.append(len(block) + 1)
+    encoded += block
+    return bytes(encoded)
+
+def cobs_decode(data):
+    decoded = bytearray()
+    index = 0
+    while index < len(data):
+        code = data[index]
+        if code == 0 or index + code > len(data):
+            return None
+        decoded += data[index + 1:index + code]
+        index += code
+        if code < 255 and index < len(data):
+            decoded.append(0)
+    return bytes(decoded)
+
+def read_frame():
+    # Text of the console is skipped up to the next frame
+    while True:
+        byte = serial_port.read(1)
+        if not byte:
+            return None
+        if byte == b'\x00':
+            break
+    frame = bytearray()
+    while True:
+        byte = serial_port.read(1)
+        if not byte:
+            return None
+        if byte == b'\x00':
+            if frame:
+                break
+            continue
+        frame += byte
+    frame = cobs_decode(bytes(frame))
+    if frame is None or len(frame) < 6:
+        return None
+    if zlib.crc32(frame[:-4]) & 0xFFFFFFFF != struct.unpack('<I', frame[-4:])[0]:
+        return None
+    return frame[0], frame[1], frame[2:-4]
+
+def request(frame_type, data=b''):
+    global seq
+    seq = (seq + 1) & 0xFF
+    frame = bytes([frame_type, seq]) + data
+    frame += struct.pack('<I', zlib.crc32(frame) & 0xFFFFFFFF)
+    for attempt in range(retries):
+        serial_port.write(b'\x00' + cobs_encode(frame) + b'\x00')
+        while True:
+            answer = read_frame()
+            if answer is None:
+                break
+            answer_type, answer_seq, answer_data = answer
+            if answer_type == frame_type | RESPONSE and answer_seq == seq:
+                if answer_data[0] != 0:
+                    raise IOError('StromPi3 answered with error %d' % answer_data[0])
+                return answer_data[1:]
+    raise IOError('No answer of the StromPi3')
+
+def status():
+    data = request(STATUS)
+    size = struct.calcsize(STATUS_FORMAT)
+    values = dict(zip(STATUS_FIELDS, struct.unpack(STATUS_FORMAT, data[:size])))
+    values['firmware'] = data[size:].decode(errors='ignore')
+    return values
+
+def config_get(index, count=1):
+    data = request(CONFIG_GET, bytes([index, count]))
+    return struct.unpack('<%dI' % count, data[1:])
+
+def config_set(index, value):
+    data = request(CONFIG_SET, struct.pack('<BI', index, value))
+    return struct.unpack('<I', data[1:])[0]
+
+serial_port.reset_input_buffer()
+
+values = status()
+print('StromPi3 %s' % values['firmware'])
+print('Time: %02d:%02d:%02d  Date: %02d.%02d.20%02d' % (values['hours'], values['minutes'], values['seconds'], values['date'], values['month'], values['year']))
+print('Mode: %d  Output: %d  Powerfailures: %d' % (values['mode'], values['output_status'], values['powerfailure_counter']))
+print('Wide: %.3f V  mUSB: %.3f V  Battery: %.3f V  Output: %.3f V' % (values['wide_range_volt'] / 1000.0, values['mUSB_volt'] / 1000.0, values['battery_volt'] / 1000.0, values['output_volt'] / 1000.0))
+for name in STATUS_FIELDS[7:35]:
+    print('%s: %d' % (name, values[name]))
+
+serial_port.close()
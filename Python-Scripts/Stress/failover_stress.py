@@ -0,0 +1,115 @@
+#!/usr/bin/env python
+import serial
+import threading
+import random
+import re
+from time import sleep
+
+##############################################################################
+# Failover stress test of the StromPi3
+#
+# The serial interface is flooded with random characters (and invalid commands),
+# so the USART1 interrupt of the StromPi3 is busy all the time, while the primary
+# voltage source is turned off and on again.
+# Afterwards the worst-case failover latency is read out through the
+# "failover-latency" command.
+#
+# The primary source can be switched by a relay at a GPIO of the Raspberry Pi
+# (relay_gpio, active high: relay on = primary source on), otherwise the script
+# asks to unplug and to plug in the primary source by hand.
+#
+# Please stop the serialShutdown scripts and disable the shutdown-timer of the
+# StromPi3 (set-config 14 0) before the test, so the Raspberry Pi isn't shut down.
+##############################################################################
+relay_gpio = None
+cycles = 20
+off_time = 2
+on_time = 5
+flood_line_length = 40
+##############################################################################
+
+breakS = 0.1
+breakL = 0.5
+
+serial_port = serial.Serial()
+
+serial_port.baudrate = 38400
+serial_port.port = '/dev/serial0'
+serial_port.timeout = 1
+serial_port.bytesize = 8
+serial_port.stopbits = 1
+serial_port.parity = serial.PARITY_NONE
+
+if serial_port.isOpen(): serial_port.close()
+serial_port.open()
+
+flooding = True
+flood_bytes = 0
+
+def flood():
+    global flood_bytes
+    while flooding:
+        line = bytearray(random.randint(0x21, 0x7E) for i in range(flood_line_length))
+        line.append(0x0D)
+        serial_port.write(line)
+        flood_bytes += len(line)
+
+def primary(on):
+    if relay_gpio is None:
+        if on:
+            input('Plug in the primary source and press Enter')
+        else:
+            input('Unplug the primary source and press Enter')
+    else:
+        GPIO.output(relay_gpio, GPIO.HIGH if on else GPIO.LOW)
+
+def command(cmd):
+    serial_port.write(str.encode(cmd))
+    sleep(breakS)
+    serial_port.write(str.encode('\x0D'))
+    sleep(breakL)
+
+if relay_gpio is not None:
+    import RPi.GPIO as GPIO
+    GPIO.setmode(GPIO.BCM)
+    GPIO.setup(relay_gpio, GPIO.OUT, initial=GPIO.HIGH)
+
+command('quit')
+command('failover-latency reset')
+serial_port.reset_input_buffer()
+
+flooder = threading.Thread(target=flood)
+flooder.start()
+
+for cycle in range(cycles):
+    print('Cycle %d of %d' % (cycle + 1, cycles))
+    primary(False)
+    sleep(off_time)
+    primary(True)
+    sleep(on_time)
+
+flooding = False
+flooder.join()
+print('Flooded %d bytes' % flood_bytes)
+
+sleep(1)
+serial_port.write(str.encode('\x0D'))
+sleep(breakL)
+serial_port.reset_input_buffer()
+
+command('failover-latency')
+output = serial_port.read(4096).decode(encoding='UTF-8', errors='ignore')
+
+found = False
+for name, count, minimum, maximum, mean in re.findall(r'(AWD -> [\w-]+): n=(\d+) min=(\d+) max=(\d+) mean=(\d+)', output):
+    found = True
+    print('%s: %s failovers, worst case %s us (min %s us, mean %s us)' % (name, count, maximum, minimum, mean))
+
+if not found:
+    print('No failover-latency output received:')
+    print(output)
+
+if relay_gpio is not None:
+    GPIO.cleanup()
+
+serial_port.close()
@@ -53,13 +53,15 @@
 
 /* Standard includes. */
 #include "string.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
 #include <inttypes.h>
 
 /*** STM32-HAL Includes ***/
 
 #include "stm32f0xx_hal.h"
 
-extern UART_HandleTypeDef huart1;
 extern RTC_HandleTypeDef hrtc;
 
 #include "cmsis_os.h"
@@ -71,8 +73,15 @@ extern RTC_HandleTypeDef hrtc;
 #include "semphr.h"
 
 #include "main.h"
+#include "latency.h"
+#include "adc_stats.h"
+#include "capture.h"
+#include "schedule.h"
+#include "task_stats.h"
+#include "uart_tx.h"
+#include "protocol.h"
+#include "uart_baud.h"
 
-uint8_t rx_ready = 0;
 uint8_t console_start = 0;
 uint8_t command_order = 0;
 
@@ -93,19 +102,73 @@ char firmwareVersion[9] = "v1.72c";
 /* Block times of 50 and 500milliseconds, specified in ticks. */
 #define cmd50ms						( ( void * ) ( 50UL / portTICK_RATE_MS ) )
 #define cmd500ms					( ( void * ) ( 500UL / portTICK_RATE_MS ) )
+
+/* Size of the circular DMA receive buffer. The task takes the characters at the idle line
+ and at every half of the buffer, so a burst of script input isn't lost while a command is processed. */
+#define cmdRX_BUFFER_SIZE			48
 /*-----------------------------------------------------------*/
 
 /*
  * The task that implements the command console processing.
  */
 static void prvUARTCommandConsoleTask(void const * pvParameters);
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+static BaseType_t prvUARTGetChar(int8_t *pcRxedChar);
+void vUARTCommandConsoleRxEvent(void);
+static void prvUARTStartReception(void);
+static void prvSendOutput(int8_t *pcOutputString);
+static void prvAppend(int8_t *pcWriteBuffer, const char *pcFormat, ...);
 
 /*-----------------------------------------------------------*/
 
 /* Holds the handle of the task that implements the UART command console. */
 static xTaskHandle xCommandConsoleTask = NULL;
 
+/* The circular DMA receive buffer and the index of the next character to be processed. */
+static uint8_t ucRxBuffer[cmdRX_BUFFER_SIZE];
+static uint16_t usRxTail = 0;
+
+/* The stack and the TCB of the console task (see ram-report). */
+static StackType_t xCommandConsoleStack[configUART_COMMAND_CONSOLE_STACK_SIZE];
+static StaticTask_t xCommandConsoleTCB;
+
+/*** The available Commands are listed here (configAPPLICATION_PROVIDES_COMMAND_TABLE), the table is kept in the flash.
+ * Please refer to the definition of the commands here at the bottom of this file (UART_CLI.c)
+ * and to the headerfile (UART_CLI.h)  ***/
+
+const CLI_Command_Definition_t * const pxCLICommandTable[] =
+{
+	&xTimeOutput,
+	&xADCOutput,
+	&xMode,
+	&xSetClock,
+	&xSetDate,
+	&xSetConfig,
+	&xStartStromPiConsole,
+	&xStartStromPiConsoleQuick,
+	&xShowStatus,
+	&xShowAlarm,
+	&xPowerOff,
+	&xTimeRPi,
+	&xDateRPi,
+	&xStatusRPi,
+	&xQuitStromPiConsole,
+	&xFailoverLatency,
+	&xADCBenchmark,
+	&xShowThresholds,
+	&xBrownoutStatus,
+	&xADCMode,
+	&xADCStats,
+	&xStatsRPi,
+	&xCapture,
+	&xSleepStats,
+	&xSchedule,
+	&xLoopStats,
+	&xRamReport,
+	&xTaskStats,
+	&xSetBaud,
+	NULL
+};
+
 static const int8_t * const pcNewLine = (int8_t *) "\r\n";
 static const int8_t * const pcEndOfCommandOutputString = (int8_t *) "\r\n>";
 
@@ -117,32 +180,13 @@ void vUARTCommandConsoleStart(void)
 
 	/*** Creates the FreeRTOS Task for the Serial Console ***/
 
-	xTaskCreate(prvUARTCommandConsoleTask, /* The task that implements the command console. */
-	(const int8_t * const ) "UARTCmd", /* Text name assigned to the task.  This is just to assist debugging.  The kernel does not use this name itself. */
+	xCommandConsoleTask = xTaskCreateStatic(prvUARTCommandConsoleTask, /* The task that implements the command console. */
+	"UARTCmd", /* Text name assigned to the task.  This is just to assist debugging.  The kernel does not use this name itself. */
 	configUART_COMMAND_CONSOLE_STACK_SIZE, /* The size of the stack allocated to the task. */
 	NULL, /* The parameter is not used, so NULL is passed. */
 	configUART_COMMAND_CONSOLE_TASK_PRIORITY,/* The priority allocated to the task. */
-	&xCommandConsoleTask); /* Used to store the handle to the created task. */
-
-	/*** The available Commands are registered here.
-	 * Please refer to the definition of the commands here at the bottom of this file (UART_CLI.c)
-	 * and to the headerfile (UART_CLI.h)  ***/
-
-	FreeRTOS_CLIRegisterCommand(&xTimeOutput);
-	FreeRTOS_CLIRegisterCommand(&xADCOutput);
-	FreeRTOS_CLIRegisterCommand(&xMode);
-	FreeRTOS_CLIRegisterCommand(&xSetClock);
-	FreeRTOS_CLIRegisterCommand(&xSetDate);
-	FreeRTOS_CLIRegisterCommand(&xSetConfig);
-	FreeRTOS_CLIRegisterCommand(&xStartStromPiConsole);
-	FreeRTOS_CLIRegisterCommand(&xStartStromPiConsoleQuick);
-	FreeRTOS_CLIRegisterCommand(&xShowStatus);
-	FreeRTOS_CLIRegisterCommand(&xShowAlarm);
-	FreeRTOS_CLIRegisterCommand(&xPowerOff);
-	FreeRTOS_CLIRegisterCommand(&xTimeRPi);
-	FreeRTOS_CLIRegisterCommand(&xDateRPi);
-	FreeRTOS_CLIRegisterCommand(&xStatusRPi);
-	FreeRTOS_CLIRegisterCommand(&xQuitStromPiConsole);
+	xCommandConsoleStack, /* The stack and the TCB are allocated statically. */
+	&xCommandConsoleTCB);
 
 }
 
@@ -167,7 +211,7 @@ void vUARTCommandConsoleStart(void)
 static void prvUARTCommandConsoleTask(void const * pvParameters)
 {
 	int8_t cRxedChar, cInputIndex = 0, *pcOutputString;
-	static int8_t cInputString[cmdMAX_INPUT_SIZE], cLastInputString[cmdMAX_INPUT_SIZE];
+	static int8_t cInputString[cmdMAX_INPUT_SIZE];
 	portBASE_TYPE xReturned;
 
 	(void) pvParameters;
@@ -177,63 +221,60 @@ static void prvUARTCommandConsoleTask(void const * pvParameters)
 	 interface will be used at any one time. */
 	pcOutputString = FreeRTOS_CLIGetOutputBuffer();
 
-	/* Send the welcome message. */
-	volatile UBaseType_t uxHighWaterMark;
-
-	uxHighWaterMark = uxTaskGetStackHighWaterMark( NULL);
+	prvUARTStartReception();
 
 	for (;;)
 	{
 		/* Only interested in reading one character at a time. */
 
-		uxHighWaterMark = uxTaskGetStackHighWaterMark( NULL);
+		/*** The DMA receives the characters into the circular buffer ucRxBuffer.
+		 * The task takes them one by one and waits here, until the idle line of USART1
+		 * or a half of the buffer wakes it up.
+		 * The task is blocked in between, so the idle task can put the core to sleep ***/
+		while (prvUARTGetChar(&cRxedChar) != pdTRUE)
+		{
+			/*** A switch of the baudrate is done here after the answer of set-baud and
+			 * the wait ends in time for the rollback of an unconfirmed switch or of an idle link ***/
+			ulTaskNotifyTake(pdTRUE, UartBaud_Process());
+		}
+
+		UartBaud_Received();
 
-		/*** Process the Serial Interface Interrupt and copy a received Character
-		 * into the predesignated buffer.
-		 * The whole task waits here in the while-loop until an interrupt gives a
-		 * signal for a processed character. ***/
-		while (rx_ready != 1)
+		/*** The characters of a binary frame (protocol.h) are neither echoed nor part of the command ***/
+		if (Protocol_Receive(cRxedChar))
 		{
-			HAL_UART_Receive_IT(&huart1, (uint8_t *) &cRxedChar, 1);
+			continue;
 		}
-		rx_ready = 0;
 
 		/* Echo the character back. */
-		if (UART_CheckIdleState(&huart1) == HAL_OK && console_start == 1)
+		if (console_start == 1)
 		{
-			HAL_UART_Transmit(&huart1, (uint8_t *) &cRxedChar, sizeof(cRxedChar), sizeof(cRxedChar));
+			UartTx_Bulk((uint8_t *) &cRxedChar, sizeof(cRxedChar));
 		}
 
 		/*** Return-Key have been pressed ***/
 		if (cRxedChar == '\r')
 		{
-			/* The input command string is complete.  Ensure the previous
-			 UART transmission has finished before sending any more data.
-			 This task will be held in the Blocked state while the Tx completes,
-			 if it has not already done so, so no CPU time will be wasted by
-			 polling. */
-			if (UART_CheckIdleState(&huart1) == HAL_OK && console_start == 1)
+			/* The input command string is complete.  The output is sent by
+			 the bulk lane of the transmit queue, this task is held in the
+			 Blocked state until it has been sent. */
+			if (console_start == 1)
 			{
-				HAL_UART_Transmit(&huart1, (uint8_t *) pcNewLine, strlen((char *) pcNewLine), strlen((char *) pcNewLine));
+				UartTx_Bulk((uint8_t *) pcNewLine, strlen((char *) pcNewLine));
 			}
 			/* See if the command is empty, indicating that the last command is
 			 to be executed again. */
-			if (cInputIndex == 0)
-			{
-				strcpy((char *) cInputString, (char *) cLastInputString);
-			}
+			/*** cInputString still holds the last command in that case, it is only
+			 * cleared with the first character of the next command ***/
 
 			/* Pass the received command to the command interpreter.  The
 			 command interpreter is called repeatedly until it returns
 			 pdFALSE as it might generate more than one string. */
 			do
 			{
-				/* Once again, just check to ensure the UART has completed
-				 sending whatever it was sending last.  This task will be held
-				 in the Blocked state while the Tx completes, if it has not
-				 already done so, so no CPU time	is wasted polling. */
-				if (UART_CheckIdleState(&huart1) == HAL_OK)
-					xReturned = pdPASS;
+				/* UartTx_Bulk() returns after the output has been sent, so the
+				 output buffer can be reused for the next string. */
+				xReturned = pdPASS;
 
 				if (xReturned == pdPASS)
 				{
@@ -242,28 +283,20 @@ static void prvUARTCommandConsoleTask(void const * pvParameters)
 					xReturned = FreeRTOS_CLIProcessCommand(cInputString, pcOutputString, configCOMMAND_INT_MAX_OUTPUT_SIZE);
 
 					/* Write the generated string to the UART. */
-					if (console_start == 1 || command_order == 1)
-					{
-						HAL_UART_Transmit(&huart1, (uint8_t *) pcOutputString, strlen((char *) pcOutputString), strlen((char *) pcOutputString));
-						command_order = 0;
-					}
+					prvSendOutput(pcOutputString);
+					command_order = 0;
 				}
 
 			} while (xReturned != pdFALSE);
 
 			/* All the strings generated by the input command have been sent.
-			 Clear the input	string ready to receive the next command.  Remember
-			 the command that was just processed first in case it is to be
-			 processed again. */
-			strcpy((char *) cLastInputString, (char *) cInputString);
+			 The command that was just processed is kept in the input string
+			 in case it is to be processed again. */
 			cInputIndex = 0;
-			memset(cInputString, 0x00, cmdMAX_INPUT_SIZE);
 
-			/* Ensure the last string to be transmitted has completed. */
-			if (UART_CheckIdleState(&huart1) == HAL_OK && console_start == 1)
+			if (console_start == 1)
 			{
-				HAL_UART_Transmit(&huart1, (uint8_t *) pcEndOfCommandOutputString, strlen((char *) pcEndOfCommandOutputString), strlen((char *) pcEndOfCommandOutputString));
-
+				UartTx_Bulk((uint8_t *) pcEndOfCommandOutputString, strlen((char *) pcEndOfCommandOutputString));
 			}
 		}
 		else
@@ -289,6 +322,12 @@ static void prvUARTCommandConsoleTask(void const * pvParameters)
 				 string will be passed to the command interpreter. */
 				if ((cRxedChar >= ' ') && (cRxedChar <= '~'))
 				{
+					if (cInputIndex == 0)
+					{
+						/*** The first character of a new command replaces the last command ***/
+						memset(cInputString, 0x00, cmdMAX_INPUT_SIZE);
+					}
+
 					if (cInputIndex < cmdMAX_INPUT_SIZE)
 					{
 						cInputString[cInputIndex] = cRxedChar;
@@ -302,6 +341,45 @@ static void prvUARTCommandConsoleTask(void const * pvParameters)
 
 /*-----------------------------------------------------------*/
 
+/*** Sends the output of a command, when the console is enabled or the command bypasses a deactivated console ***/
+
+static void prvSendOutput(int8_t *pcOutputString)
+{
+	if (console_start == 1 || command_order == 1)
+	{
+		UartTx_Bulk((uint8_t *) pcOutputString, strlen((char *) pcOutputString));
+	}
+}
+
+/*** prvAppend
+ * Appends formatted text to the output of a command. If the text doesn't fit into
+ * the output buffer (configCOMMAND_INT_MAX_OUTPUT_SIZE), the buffer is sent first and the text
+ * starts a new buffer. UartTx_Bulk() returns after the output has been sent, so the long outputs
+ * (show-status, adc-stats...) don't need a buffer of their full length ***/
+
+static void prvAppend(int8_t *pcWriteBuffer, const char *pcFormat, ...)
+{
+	va_list xArgs;
+	size_t xLength = strlen((char *) pcWriteBuffer);
+	int iRequired;
+
+	va_start(xArgs, pcFormat);
+	iRequired = vsnprintf((char *) pcWriteBuffer + xLength, configCOMMAND_INT_MAX_OUTPUT_SIZE - xLength, pcFormat, xArgs);
+	va_end(xArgs);
+
+	if (xLength > 0 && xLength + iRequired >= configCOMMAND_INT_MAX_OUTPUT_SIZE)
+	{
+		pcWriteBuffer[xLength] = 0;
+		prvSendOutput(pcWriteBuffer);
+
+		va_start(xArgs, pcFormat);
+		vsnprintf((char *) pcWriteBuffer, configCOMMAND_INT_MAX_OUTPUT_SIZE, pcFormat, xArgs);
+		va_end(xArgs);
+	}
+}
+
+/*-----------------------------------------------------------*/
+
 /*** In the following section you'll find the definition of the preregistered Commands
  * Please refer also to the UART_CLI.h file***/
 
@@ -316,7 +394,7 @@ static portBASE_TYPE prvADCOutput(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 	/* This function assumes the buffer length is adequate. */
 	(void) xWriteBufferLen;
 
-	if (rawValue[0] > minWide)
+	if (rawValue[0] > minWide_fail)
 	{
 		sprintf((char *) pcWriteBuffer, "****************************\r\nWide-Range-Inputvoltage: %d.%03d V", measuredValue[0] / 1000, measuredValue[0] % 1000);
 	}
@@ -326,46 +404,46 @@ static portBASE_TYPE prvADCOutput(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 	}
 	if (rawValue[1] > minBatConnect)
 	{
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\nLifePo4-Batteryvoltage: %d.%03d V", measuredValue[1] / 1000, measuredValue[1] % 1000);
+		prvAppend(pcWriteBuffer, "\r\nLifePo4-Batteryvoltage: %d.%03d V", measuredValue[1] / 1000, measuredValue[1] % 1000);
 
 		switch (batLevel)
 		{
 		case 1:
-			sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), " [10%%]");
+			prvAppend(pcWriteBuffer, " [10%%]");
 			break;
 
 		case 2:
-			sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), " [25%%]");
+			prvAppend(pcWriteBuffer, " [25%%]");
 			break;
 
 		case 3:
-			sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), " [50%%]");
+			prvAppend(pcWriteBuffer, " [50%%]");
 			break;
 
 		case 4:
-			sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), " [100%%]");
+			prvAppend(pcWriteBuffer, " [100%%]");
 			break;
 
 		}
 
 		if (charging == 1)
 		{
-			sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), " [charging]");
+			prvAppend(pcWriteBuffer, " [charging]");
 		}
 	}
 	else
 	{
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\nLifePo4-Batteryvoltage: not connected");
+		prvAppend(pcWriteBuffer, "\r\nLifePo4-Batteryvoltage: not connected");
 	}
-	if (rawValue[2] > minUSB)
+	if (rawValue[2] > minUSB_fail)
 	{
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\nmicroUSB-Inputvoltage: %d.%03d V", measuredValue[2] / 1000, measuredValue[2] % 1000);
+		prvAppend(pcWriteBuffer, "\r\nmicroUSB-Inputvoltage: %d.%03d V", measuredValue[2] / 1000, measuredValue[2] % 1000);
 	}
 	else
 	{
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\nmicroUSB-Inputvoltage: not connected");
+		prvAppend(pcWriteBuffer, "\r\nmicroUSB-Inputvoltage: not connected");
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\nOutput-Voltage: %d.%03d V\r\n****************************\r\n", measuredValue[3] / 1000, measuredValue[3] % 1000);
+	prvAppend(pcWriteBuffer, "\r\nOutput-Voltage: %d.%03d V\r\n****************************\r\n", measuredValue[3] / 1000, measuredValue[3] % 1000);
 
 	/* There is no more data to return after this single string, so return
 	 pdFALSE. */
@@ -425,6 +503,8 @@ static portBASE_TYPE prvMode(int8_t *pcWriteBuffer, size_t xWriteBufferLen, cons
 
 	strcpy((char *) pcWriteBuffer, (char *) pcMessage);
 
+	updateFailoverPath();
+
 	/*** The updated "modus"-variable is written into the flash ***/
 	flashConfig();
 
@@ -533,6 +613,8 @@ static portBASE_TYPE prvSetClock(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		Error_Handler();
 	}
 
+	Schedule_Reschedule();
+
 	sprintf((char *) pcWriteBuffer, "The clock has been set to %02d:%02d:%02d", stimestructure.Hours, stimestructure.Minutes, stimestructure.Seconds);
 
 	/* There is no more data to return after this single string, so return
@@ -628,6 +710,8 @@ static portBASE_TYPE prvSetDate(int8_t *pcWriteBuffer, size_t xWriteBufferLen, c
 		Error_Handler();
 	}
 
+	Schedule_Reschedule();
+
 	switch (weekday)
 	{
 	case 1:
@@ -708,60 +792,7 @@ static portBASE_TYPE prvSetConfig(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 	commandParameter1 = ascii2int(pcParameter1);
 	commandParameter2 = ascii2int(pcParameter2);
 
-	if (commandParameter1 == 0 && commandParameter2 == 0)
-	{
-		updateConfig();
-	}
-	else if (commandParameter1 == 0 && commandParameter2 == 1)
-	{
-		updateConfig();
-		reconfigureWatchdog();
-	}
-	else if (commandParameter1 == 0 && commandParameter2 == 2)
-	{
-		if (serialLessMode == 1)
-		{
-			serialLess_communication_off_counter = 5;
-		}
-	}
-	else if (commandParameter1 == 1)
-	{
-		configParamters[commandParameter1] = commandParameter2;
-		if (commandParameter2 < 5)
-		{
-			threeStageMode = 0;
-		}
-		else if (commandParameter2 == 5)
-		{
-			threeStageMode = 1;
-			modus = 1;
-		}
-		else if (commandParameter2 == 6)
-		{
-			threeStageMode = 2;
-			modus = 2;
-		}
-
-	}
-	else if (commandParameter1 == 24)
-	{
-		configParamters[commandParameter1] = commandParameter2;
-		if (commandParameter2 == 1)
-		{
-			if (output_status == 0x2)
-			{
-				HAL_GPIO_WritePin(CTRL_L7987_GPIO_Port, CTRL_L7987_Pin, GPIO_PIN_SET);
-			}
-			else
-			{
-				HAL_GPIO_WritePin(CTRL_L7987_GPIO_Port, CTRL_L7987_Pin, GPIO_PIN_RESET);
-			}
-		}
-	}
-	else if (commandParameter1 > 1 && commandParameter1 <= configMax)
-	{
-		configParamters[commandParameter1] = commandParameter2;
-	}
+	setConfig(commandParameter1, commandParameter2);
 
 	strcpy((char *) pcWriteBuffer, (char *) pcMessage);
 
@@ -796,7 +827,9 @@ static portBASE_TYPE prvStartStromPiConsole(int8_t *pcWriteBuffer, size_t xWrite
 
 	console_start = 1;
 
-	strcpy((char *) pcWriteBuffer, (char *) pcMessage);
+	/*** The welcome message is longer than the output buffer, so it is sent from the flash ***/
+	prvSendOutput((int8_t *) pcMessage);
+	pcWriteBuffer[0] = 0x00;
 
 	return pdFALSE;
 }
@@ -821,7 +854,9 @@ static portBASE_TYPE prvStartStromPiConsoleQuick(int8_t *pcWriteBuffer, size_t x
 
 	console_start = 1;
 
-	strcpy((char *) pcWriteBuffer, (char *) pcMessage);
+	/*** The welcome message is longer than the output buffer, so it is sent from the flash ***/
+	prvSendOutput((int8_t *) pcMessage);
+	pcWriteBuffer[0] = 0x00;
 
 	return pdFALSE;
 }
@@ -879,6 +914,8 @@ static portBASE_TYPE prvPowerOff(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 
 	Config_Reset_Pin_Input_PullDOWN();
 
+	notifyMainTask(mainEventShutdown);
+
 	strcpy((char *) pcWriteBuffer, (char *) pcMessage);
 
 	return pdFALSE;
@@ -993,9 +1030,9 @@ static portBASE_TYPE prvStatusRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 
 	sprintf((char *) pcWriteBuffer, "%lu\n", time);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", date);
+	prvAppend(pcWriteBuffer, "%lu\n", date);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", sdatestructureget.WeekDay);
+	prvAppend(pcWriteBuffer, "%lu\n", sdatestructureget.WeekDay);
 
 	if (threeStageMode > 0)
 	{
@@ -1005,21 +1042,21 @@ static portBASE_TYPE prvStatusRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		{
 		case 1:
 			modetemp = 5;
-			sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", modetemp);
+			prvAppend(pcWriteBuffer, "%lu\n", modetemp);
 			break;
 		case 2:
 			modetemp = 6;
-			sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", modetemp);
+			prvAppend(pcWriteBuffer, "%lu\n", modetemp);
 			break;
 		}
 	}
 
 	else
 	{
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", modus);
+		prvAppend(pcWriteBuffer, "%lu\n", modus);
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_enable);
 
 	if (alarmTime == 1)
 		alarm_mode_tmp = 1;
@@ -1028,73 +1065,73 @@ static portBASE_TYPE prvStatusRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 	else if (alarmWeekDay == 1)
 		alarm_mode_tmp = 3;
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_mode_tmp);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_mode_tmp);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_hour);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_hour);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_min);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_min);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_day);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_day);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_month);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_month);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_weekday);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_weekday);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarmPoweroff);
+	prvAppend(pcWriteBuffer, "%lu\n", alarmPoweroff);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_hour_off);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_hour_off);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarm_min_off);
+	prvAppend(pcWriteBuffer, "%lu\n", alarm_min_off);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", shutdown_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", shutdown_enable);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", shutdown_time);
+	prvAppend(pcWriteBuffer, "%lu\n", shutdown_time);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", warning_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", warning_enable);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", serialLessMode);
+	prvAppend(pcWriteBuffer, "%lu\n", serialLessMode);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarmInterval);
+	prvAppend(pcWriteBuffer, "%lu\n", alarmInterval);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarmIntervalMinOn);
+	prvAppend(pcWriteBuffer, "%lu\n", alarmIntervalMinOn);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", alarmIntervalMinOff);
+	prvAppend(pcWriteBuffer, "%lu\n", alarmIntervalMinOff);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", batLevel_shutdown);
+	prvAppend(pcWriteBuffer, "%lu\n", batLevel_shutdown);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", batLevel);
+	prvAppend(pcWriteBuffer, "%lu\n", batLevel);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", charging);
+	prvAppend(pcWriteBuffer, "%lu\n", charging);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", powerOnButton_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", powerOnButton_enable);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", powerOnButton_time);
+	prvAppend(pcWriteBuffer, "%lu\n", powerOnButton_time);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", powersave_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", powersave_enable);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", poweroff_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", poweroff_enable);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", wakeup_time_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", wakeup_time_enable);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", wakeup_time);
+	prvAppend(pcWriteBuffer, "%lu\n", wakeup_time);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", wakeupweekend_enable);
+	prvAppend(pcWriteBuffer, "%lu\n", wakeupweekend_enable);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", measuredValue[0]);
+	prvAppend(pcWriteBuffer, "%lu\n", measuredValue[0]);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", measuredValue[1]);
+	prvAppend(pcWriteBuffer, "%lu\n", measuredValue[1]);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", measuredValue[2]);
+	prvAppend(pcWriteBuffer, "%lu\n", measuredValue[2]);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", measuredValue[3]);
+	prvAppend(pcWriteBuffer, "%lu\n", measuredValue[3]);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", output_status);
+	prvAppend(pcWriteBuffer, "%lu\n", output_status);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "%lu\n", powerfailure_counter);
+	prvAppend(pcWriteBuffer, "%lu\n", powerfailure_counter);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), firmwareVersion);
+	prvAppend(pcWriteBuffer, firmwareVersion);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\n");
+	prvAppend(pcWriteBuffer, "\n");
 
 	return pdFALSE;
 
@@ -1151,7 +1188,7 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n Date: %s %02d.%02d.20%02d\r\n", temp_message, sdatestructureget.Date, sdatestructureget.Month, sdatestructureget.Year);
+	prvAppend(pcWriteBuffer, "\r\n Date: %s %02d.%02d.20%02d\r\n", temp_message, sdatestructureget.Date, sdatestructureget.Month, sdatestructureget.Year);
 
 	switch (output_status)
 	{
@@ -1168,7 +1205,7 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		strcpy(temp_message, "Battery");
 		break;
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n StromPi-Output:  %s \r\n", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n StromPi-Output:  %s \r\n", temp_message);
 
 	if (threeStageMode > 0)
 	{
@@ -1207,7 +1244,7 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 			break;
 		}
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n StromPi-Mode: %s \r\n", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n StromPi-Mode: %s \r\n", temp_message);
 
 	switch (shutdown_enable)
 	{
@@ -1219,9 +1256,9 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n Raspberry Pi Shutdown: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n Raspberry Pi Shutdown: %s ", temp_message);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Shutdown-Timer: %d seconds", shutdown_time);
+	prvAppend(pcWriteBuffer, "\r\n  Shutdown-Timer: %d seconds", shutdown_time);
 
 	switch (warning_enable)
 	{
@@ -1232,7 +1269,7 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		strcpy(temp_message, "Enabled");
 		break;
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Powerfail Warning: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n\r\n Powerfail Warning: %s ", temp_message);
 
 	switch (serialLessMode)
 	{
@@ -1243,7 +1280,7 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		strcpy(temp_message, "Enabled");
 		break;
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Serial-Less Mode: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n\r\n Serial-Less Mode: %s ", temp_message);
 
 	switch (powersave_enable)
 	{
@@ -1254,7 +1291,7 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		strcpy(temp_message, "Enabled");
 		break;
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Power Save Mode: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n\r\n Power Save Mode: %s ", temp_message);
 
 	switch (poweroff_enable)
 	{
@@ -1265,25 +1302,25 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		strcpy(temp_message, "Enabled");
 		break;
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Power-Off Mode: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n\r\n Power-Off Mode: %s ", temp_message);
 
 	switch (batLevel_shutdown)
 	{
 	case 0:
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Battery-Level Shutdown: Disabled");
+		prvAppend(pcWriteBuffer, "\r\n\r\n Battery-Level Shutdown: Disabled");
 		break;
 	case 1:
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Battery-Level Shutdown: 10%%");
+		prvAppend(pcWriteBuffer, "\r\n\r\n Battery-Level Shutdown: 10%%");
 		break;
 	case 2:
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Battery-Level Shutdown: 25%%");
+		prvAppend(pcWriteBuffer, "\r\n\r\n Battery-Level Shutdown: 25%%");
 		break;
 	case 3:
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Battery-Level Shutdown: 50%%");
+		prvAppend(pcWriteBuffer, "\r\n\r\n Battery-Level Shutdown: 50%%");
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n Powerfailure-Counter: %d", powerfailure_counter);
+	prvAppend(pcWriteBuffer, "\r\n\r\n Powerfailure-Counter: %d", powerfailure_counter);
 
 	switch (powerOnButton_enable)
 	{
@@ -1295,13 +1332,13 @@ static portBASE_TYPE prvShowStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n PowerOn-Button: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n\r\n PowerOn-Button: %s ", temp_message);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  PowerOn-Button-Timer: %d seconds", powerOnButton_time);
+	prvAppend(pcWriteBuffer, "\r\n  PowerOn-Button-Timer: %d seconds", powerOnButton_time);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n\r\n FirmwareVersion: ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n\r\n FirmwareVersion: ", temp_message);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), firmwareVersion, temp_message);
+	prvAppend(pcWriteBuffer, firmwareVersion, temp_message);
 
 	/* There is no more data to return after this single string, so return
 	 pdFALSE. */
@@ -1358,7 +1395,7 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n Date: %s %02d.%02d.20%02d\r\n", temp_message, sdatestructureget.Date, sdatestructureget.Month, sdatestructureget.Year);
+	prvAppend(pcWriteBuffer, "\r\n Date: %s %02d.%02d.20%02d\r\n", temp_message, sdatestructureget.Date, sdatestructureget.Month, sdatestructureget.Year);
 
 	switch (alarm_enable)
 	{
@@ -1369,7 +1406,7 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		strcpy(temp_message, "Enabled");
 		break;
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n WakeUp-Alarm: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n WakeUp-Alarm: %s ", temp_message);
 
 	if (wakeup_time_enable == 1)
 		strcpy(temp_message, "Minute Wakeup Alarm");
@@ -1380,21 +1417,21 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 	else if (alarmWeekDay == 1)
 		strcpy(temp_message, "Weekday-Alarm");
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Alarm-Mode: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n  Alarm-Mode: %s ", temp_message);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Alarm-Time: %02d:%02d", alarm_hour, alarm_min);
+	prvAppend(pcWriteBuffer, "\r\n  Alarm-Time: %02d:%02d", alarm_hour, alarm_min);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Alarm-Date: %02d.%02d", alarm_day, alarm_month);
+	prvAppend(pcWriteBuffer, "\r\n  Alarm-Date: %02d.%02d", alarm_day, alarm_month);
 
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "  \r\n  Minute Wakeup Time: %d ", wakeup_time);
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "minutes");
+	prvAppend(pcWriteBuffer, "  \r\n  Minute Wakeup Time: %d ", wakeup_time);
+	prvAppend(pcWriteBuffer, "minutes");
 
 
 	if (wakeup_time_enable == 1)
 	{
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "  \r\n  Minute Wakeup Time: %d ", wakeup_time);
-		sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "minutes");
+		prvAppend(pcWriteBuffer, "  \r\n  Minute Wakeup Time: %d ", wakeup_time);
+		prvAppend(pcWriteBuffer, "minutes");
 	}
 
 	switch (alarm_weekday)
@@ -1422,7 +1459,7 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Alarm-Weekday: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n  Alarm-Weekday: %s ", temp_message);
 
 	switch (wakeupweekend_enable)
 	{
@@ -1434,7 +1471,7 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Weekend Wake-Up: %s \r\n ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n  Weekend Wake-Up: %s \r\n ", temp_message);
 
 	switch (alarmPoweroff)
 	{
@@ -1445,9 +1482,9 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		strcpy(temp_message, "Enabled");
 		break;
 	}
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n PowerOff-Alarm: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n PowerOff-Alarm: %s ", temp_message);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  PowerOff-Alarm-Time: %02d:%02d\r\n", alarm_hour_off, alarm_min_off);
+	prvAppend(pcWriteBuffer, "\r\n  PowerOff-Alarm-Time: %02d:%02d\r\n", alarm_hour_off, alarm_min_off);
 
 	switch (alarmInterval)
 	{
@@ -1459,11 +1496,11 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 		break;
 	}
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n Interval-Alarm: %s ", temp_message);
+	prvAppend(pcWriteBuffer, "\r\n Interval-Alarm: %s ", temp_message);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Interval-Alarm-OnTime: %d minutes\r", alarmIntervalMinOn);
+	prvAppend(pcWriteBuffer, "\r\n  Interval-Alarm-OnTime: %d minutes\r", alarmIntervalMinOn);
 
-	sprintf((char *) pcWriteBuffer + strlen((char *) pcWriteBuffer), "\r\n  Interval-Alarm-OffTime: %d minutes\r\n", alarmIntervalMinOff);
+	prvAppend(pcWriteBuffer, "\r\n  Interval-Alarm-OffTime: %d minutes\r\n", alarmIntervalMinOff);
 
 	/* There is no more data to return after this single string, so return
 	 pdFALSE. */
@@ -1472,38 +1509,1047 @@ static portBASE_TYPE prvShowAlarm(int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 
 /*-----------------------------------------------------------*/
 
-/*** ascii2int
- * This is a help function to convert the input of the user into the correct format for storing into the associated variables
+/*** prvFailoverLatency
+ * This command outputs the failover latency statistics in microseconds (see latency.h)
+ *
+ * - "AWD -> PowerPath": from the entry of the ADC-Watchdog interrupt up to the switched PowerPath
+ * - "AWD -> Main-Task": from the entry of the ADC-Watchdog interrupt up to the processing in the main Task
+ * - "Time-to-Protection at boot": up to the arming of the ADC-Watchdog in main() (see startProtection in main.c)
+ *
+ * The histogram lists the counts of the bins 0us, <4us, <16us, <64us, ... (the last bin counts everything above)
+ * With the parameter "reset" the statistics are cleared.
+ * Like status-rpi it uses the command_order=1 flag to bypass a deactivated console_output,
+ * so the failover stress test (Python-Scripts/Stress/failover_stress.py) can read it after "quit".
  *
  * ***/
 
-int ascii2int(const char* s)
+static void prvPrintLatencyStat(int8_t *pcWriteBuffer, const char *pcName, const LatencyStat_t *stat)
 {
-	int i = 0;
-	while (*s != 0)
+	uint8_t bin;
+
+	prvAppend(pcWriteBuffer, "\r\n %s: n=%lu min=%lu max=%lu mean=%lu\r\n  hist:", pcName, stat->count, stat->min, stat->max, stat->count ? stat->sum / stat->count : 0);
+
+	for (bin = 0; bin < LATENCY_HIST_BINS; bin++)
 	{
-		if (*s >= '0' && *s <= '9')
+		prvAppend(pcWriteBuffer, " %u", stat->hist[bin]);
+	}
+}
+
+static portBASE_TYPE prvFailoverLatency(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	int8_t *pcParameter1;
+	BaseType_t xParameter1StringLength = 0;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	if (pcParameter1 != NULL && xParameter1StringLength == 5 && strncmp((char *) pcParameter1, "reset", 5) == 0)
+	{
+		Latency_Reset();
+	}
+
+	command_order = 1;
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nFailover-Latency [us]");
+
+	prvPrintLatencyStat(pcWriteBuffer, "AWD -> PowerPath", &latency_switch);
+	prvPrintLatencyStat(pcWriteBuffer, "AWD -> Main-Task", &latency_task);
+
+	prvAppend(pcWriteBuffer, "\r\n\r\nTime-to-Protection at boot: %lu ms (TIM2: %lu us)", latency_boot_tick, latency_boot_timestamp);
+
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvLoopStats
+ * This command outputs the period of the main loop (set-config 38) and its statistics in microseconds (see latency.h)
+ *
+ * - "Execution": the time from the start of the main loop up to its wait for the next period
+ * - "Jitter": the deviation of the measured period from the configured period
+ *
+ * The histogram is the same as in failover-latency, with the parameter "reset" the statistics are cleared.
+ *
+ * ***/
+
+static portBASE_TYPE prvLoopStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	int8_t *pcParameter1;
+	BaseType_t xParameter1StringLength = 0;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	if (pcParameter1 != NULL && xParameter1StringLength == 5 && strncmp((char *) pcParameter1, "reset", 5) == 0)
+	{
+		Latency_ResetLoop();
+	}
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nMain-Loop: %u ms period [us]", loop_period);
+
+	prvPrintLatencyStat(pcWriteBuffer, "Execution", &latency_loop_execution);
+	prvPrintLatencyStat(pcWriteBuffer, "Jitter", &latency_loop_jitter);
+
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvRamReport
+ * This command outputs the RAM budget in bytes: all tasks are allocated statically (configSUPPORT_STATIC_ALLOCATION),
+ * so the RAM is split at link time into the static data (including the task stacks), the heap and the stack of the
+ * interrupts (see STM32F031F6_FLASH.ld). For every task the size of its stack and its unused part
+ * (high water mark, the least free space since the start) are shown.
+ *
+ * ***/
+
+extern osThreadId defaultTaskHandle;
+
+extern uint8_t _sdata;
+extern uint8_t _end;
+extern uint8_t _estack;
+extern uint8_t _Min_Heap_Size;
+extern uint8_t _Min_Stack_Size;
+
+static void prvPrintStack(int8_t *pcWriteBuffer, const char *name, TaskHandle_t task, uint32_t size)
+{
+	prvAppend(pcWriteBuffer, "\r\n %s: %lu (free %lu)", name, size * sizeof(StackType_t),
+			(uint32_t) uxTaskGetStackHighWaterMark(task) * sizeof(StackType_t));
+}
+
+static portBASE_TYPE prvRamReport(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	uint32_t staticSize = &_end - &_sdata;
+	uint32_t heapSize = (uint32_t) &_Min_Heap_Size;
+	uint32_t stackSize = (uint32_t) &_Min_Stack_Size;
+
+	(void) pcCommandString;
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nRAM [bytes]");
+	prvAppend(pcWriteBuffer, "\r\n Static (data, bss): %lu", staticSize);
+	prvAppend(pcWriteBuffer, "\r\n Heap: %lu", heapSize);
+	prvAppend(pcWriteBuffer, "\r\n Interrupt-Stack: %lu", stackSize);
+	prvAppend(pcWriteBuffer, "\r\n Unused: %lu", (uint32_t) (&_estack - &_end) - heapSize - stackSize);
+
+	prvAppend(pcWriteBuffer, "\r\n\r\nTask-Stacks [bytes]");
+	prvPrintStack(pcWriteBuffer, "Main", defaultTaskHandle, mainTaskStackSize);
+	prvPrintStack(pcWriteBuffer, "Console", xCommandConsoleTask, configUART_COMMAND_CONSOLE_STACK_SIZE);
+	prvPrintStack(pcWriteBuffer, "Idle", xTaskGetIdleTaskHandle(), configIDLE_TASK_STACK_SIZE);
+
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvTaskStats
+ * This command outputs the statistics of the interval since its last call (see task_stats.h):
+ * the CPU share and the stack high water mark of every task, the idle time of the core
+ * (the share of the idle task) and the number of interrupts.
+ *
+ * ***/
+
+static portBASE_TYPE prvTaskStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	static const char * const isrName[TASK_STATS_ISRS] =
+	{ "ADC", "DMA", "USART1", "TIM14" };
+	TaskStats_t stats;
+	uint8_t index;
+
+	(void) pcCommandString;
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	TaskStats_Sample(&stats);
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nTasks (last %lu ms): CPU [%%] / Stack free [bytes]", stats.interval / 1000);
+
+	for (index = 0; index < stats.tasks; index++)
+	{
+		prvAppend(pcWriteBuffer, "\r\n %s: %u.%u / %u", stats.task[index].name, stats.task[index].share / 10,
+				stats.task[index].share % 10, stats.task[index].stackFree);
+	}
+
+	prvAppend(pcWriteBuffer, "\r\n Idle: %u.%u %%", stats.idle / 10, stats.idle % 10);
+
+	prvAppend(pcWriteBuffer, "\r\n\r\nInterrupts");
+	for (index = 0; index < TASK_STATS_ISRS; index++)
+	{
+		prvAppend(pcWriteBuffer, "\r\n %s: %lu", isrName[index], stats.isr[index]);
+	}
+
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvSetBaud
+ * This command negotiates the baudrate of the serial interface (see uart_baud.h):
+ * - "set-baud <rate>" switches to the rate after the answer, the switch has to be confirmed with the new rate
+ * - "set-baud ok" confirms the switch, otherwise the StromPi3 returns to 38400 baud
+ * - "set-baud" outputs the actual baudrate
+ *
+ * Like status-rpi it uses the command_order=1 flag to bypass a deactivated console_output.
+ *
+ * ***/
+
+static portBASE_TYPE prvSetBaud(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	int8_t *pcParameter1;
+	BaseType_t xParameter1StringLength = 0;
+	uint32_t rate;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	command_order = 1;
+
+	if (pcParameter1 == NULL)
+	{
+		sprintf((char *) pcWriteBuffer, "Baudrate: %lu\r\n", UartBaud_Rate());
+	}
+	else if (xParameter1StringLength == 2 && strncmp((char *) pcParameter1, "ok", 2) == 0)
+	{
+		if (UartBaud_Confirm())
 		{
-			i = i * 10 + (*s - '0');
-			s++;
+			sprintf((char *) pcWriteBuffer, "Baudrate confirmed: %lu\r\n", UartBaud_Rate());
 		}
 		else
-			return 0;
+		{
+			sprintf((char *) pcWriteBuffer, "No baudrate to confirm\r\n");
+		}
 	}
-	return i;
+	else
+	{
+		pcParameter1[xParameter1StringLength] = 0x00;
+		rate = ascii2int((char *) pcParameter1);
+
+		if (UartBaud_Request(rate))
+		{
+			sprintf((char *) pcWriteBuffer, "Baudrate: %lu, confirm with set-baud ok within %u s\r\n", rate, uartBaudConfirmTime / 1000);
+		}
+		else
+		{
+			sprintf((char *) pcWriteBuffer, "Baudrate not supported (38400, 57600, 115200, 230400, 460800, 500000, 921600 or 1000000)\r\n");
+		}
+	}
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvADCBenchmark
+ * This command compares the CPU-Cycles of the previous ADC-Voltage conversion (with divisions)
+ * with the fixed-point conversion of updateMeasuredValues() (main.c)
+ *
+ * ***/
+
+static portBASE_TYPE prvADCBenchmark(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	uint32_t cycles[3];
+
+	(void) pcCommandString;
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	benchmarkADCConversion(cycles);
 
+	sprintf((char *) pcWriteBuffer, "****************************\r\nADC-Conversion [CPU-Cycles]");
+	prvAppend(pcWriteBuffer, "\r\n Division: %lu", cycles[0]);
+	prvAppend(pcWriteBuffer, "\r\n Fixed-Point (VREFINT changed): %lu", cycles[1]);
+	prvAppend(pcWriteBuffer, "\r\n Fixed-Point (cached): %lu", cycles[2]);
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
 }
 
 /*-----------------------------------------------------------*/
 
-/*** HAL_UART_RxCpltCallback
- * This is the STM32 Hal UART Interrupt Callback
+/*** prvShowThresholds
+ * This command outputs the fail- and restore-thresholds (raw ADC-Values) of the primary sources
+ * and the minimum stable time, which the primary source needs above the restore-threshold before it is restored.
+ * They are configured with set-config 29 to 33
  *
  * ***/
 
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+static portBASE_TYPE prvShowThresholds(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
 {
+	(void) pcCommandString;
+	configASSERT(pcWriteBuffer);
 
-	rx_ready = 1;
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nFailover-Thresholds [ADC-Value]");
+	prvAppend(pcWriteBuffer, "\r\n mUSB: Fail %d / Restore %d (actual %d)", minUSB_fail, minUSB_restore, rawValue[2]);
+	prvAppend(pcWriteBuffer, "\r\n Wide: Fail %d / Restore %d (actual %d)", minWide_fail, minWide_restore, rawValue[0]);
+	prvAppend(pcWriteBuffer, "\r\n Restore-Stable-Time: %d ms", restore_stable_time);
+	prvAppend(pcWriteBuffer, "\r\n Power-Back-Interrupts: %d", powerback_irq_counter);
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvBrownoutStatus
+ * This command outputs the configuration and the counters of the predictive brown-out detection
+ * (set-config 34: mode 0=off 1=pre-arm 2=early failover, set-config 35: rate in ADC-Value per ms)
+ *
+ * - "Slope-Failovers" counts the failovers, which have been switched by the slope of the primary source
+ * - "Threshold-Failovers" counts the failovers, which have been switched by the ADC-Watchdog threshold
+ * - "Peak-Slope" is the fastest drop of the primary source since the last reset
+ *
+ * With the parameter "reset" the counters are cleared.
+ *
+ * ***/
+
+static portBASE_TYPE prvBrownoutStatus(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	int8_t *pcParameter1;
+	BaseType_t xParameter1StringLength = 0;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	if (pcParameter1 != NULL && xParameter1StringLength == 5 && strncmp((char *) pcParameter1, "reset", 5) == 0)
+	{
+		resetSlopeCounters();
+	}
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nPredictive Brown-Out Detection");
+	prvAppend(pcWriteBuffer, "\r\n Mode: %d Rate: %d ADC-Value/ms", slope_mode, slope_rate);
+	prvAppend(pcWriteBuffer, "\r\n Peak-Slope: %lu ADC-Value/ms", slope_peak_time ? (uint32_t) slope_peak_drop * 1000 / slope_peak_time : 0);
+	prvAppend(pcWriteBuffer, "\r\n Pre-Arms: %d", slope_prearm_counter);
+	prvAppend(pcWriteBuffer, "\r\n Slope-Failovers: %d", slope_failover_counter);
+	prvAppend(pcWriteBuffer, "\r\n Threshold-Failovers: %d", threshold_failover_counter);
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvADCMode
+ * This command outputs the ADC acquisition mode or changes it, when a rate and the auto-off setting are given:
+ *
+ * - adc-mode 0 0: the ADC is converting continuously (lowest failover latency)
+ * - adc-mode <rate> <autooff>: TIM3 triggers <rate> scans per second (1 to 1000), with <autooff> 1
+ *   the ADC is powered off between the scans (lowest quiescent current)
+ *
+ * The new mode is stored into the flash together with the rest of the configuration (set-config 36 and 37)
+ *
+ * ***/
+
+static portBASE_TYPE prvADCMode(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	int8_t *pcParameter1;
+	int8_t *pcParameter2;
+	BaseType_t xParameter1StringLength = 0;
+	BaseType_t xParameter2StringLength = 0;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+	pcParameter2 = FreeRTOS_CLIGetParameter(pcCommandString, 2, &xParameter2StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	if (pcParameter1 != NULL && pcParameter2 != NULL)
+	{
+		pcParameter1[xParameter1StringLength] = 0x00;
+		pcParameter2[xParameter2StringLength] = 0x00;
+
+		configParamters[36] = ascii2int(pcParameter1);
+		configParamters[37] = ascii2int(pcParameter2);
+
+		updateConfig();
+	}
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nADC-Mode: ");
+
+	if (adc_rate == 0)
+	{
+		prvAppend(pcWriteBuffer, "continuous");
+	}
+	else
+	{
+		prvAppend(pcWriteBuffer, "%d scans/s (TIM3)", adc_rate);
+		if (adc_autooff == 1)
+		{
+			prvAppend(pcWriteBuffer, " auto-off");
+		}
+	}
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvADCStats
+ * This command outputs the statistics of the last completed 1-second, 1-minute or 1-hour window
+ * (parameter s, m or h - default is s) of all ADC channels (see adc_stats.h)
+ *
+ * prvGetStatMillivolts copies a window of a channel and converts it into millivolts,
+ * for the VDD channel the minimum and maximum are swapped, because VDD is inverse to the VREFINT ADC-Value
+ *
+ * ***/
+
+static const char * const pcStatChannelNames[adcChannels] =
+{ "Wide", "Battery", "mUSB", "Output", "VDD" };
+
+static void prvGetStatMillivolts(uint8_t window, uint8_t channel, ADCStat_t *mv)
+{
+	ADCStat_t raw;
+
+	taskENTER_CRITICAL();
+	raw = adc_stats[window][channel];
+	taskEXIT_CRITICAL();
+
+	mv->mean = convertADCValue(channel, raw.mean);
+
+	if (channel < 4)
+	{
+		mv->min = convertADCValue(channel, raw.min);
+		mv->max = convertADCValue(channel, raw.max);
+		mv->stddev = convertADCValue(channel, raw.stddev);
+	}
+	else
+	{
+		mv->min = convertADCValue(channel, raw.max);
+		mv->max = convertADCValue(channel, raw.min);
+		mv->stddev = raw.mean != 0 ? (uint32_t) mv->mean * raw.stddev / raw.mean : 0;
+	}
+}
+
+static portBASE_TYPE prvADCStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	int8_t *pcParameter1;
+	BaseType_t xParameter1StringLength = 0;
+	uint8_t window = ADC_STATS_SECOND;
+	uint8_t channel;
+	ADCStat_t mv;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	if (pcParameter1 != NULL && xParameter1StringLength == 1)
+	{
+		if (pcParameter1[0] == 'm')
+		{
+			window = ADC_STATS_MINUTE;
+		}
+		else if (pcParameter1[0] == 'h')
+		{
+			window = ADC_STATS_HOUR;
+		}
+	}
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nADC-Statistics [V] (%s)", window == ADC_STATS_SECOND ? "1 second" : window == ADC_STATS_MINUTE ? "1 minute" : "1 hour");
+
+	if (adc_stats_valid[window] == 0)
+	{
+		prvAppend(pcWriteBuffer, "\r\n not completed yet");
+	}
+	else
+	{
+		for (channel = 0; channel < adcChannels; channel++)
+		{
+			prvGetStatMillivolts(window, channel, &mv);
+			prvAppend(pcWriteBuffer, "\r\n %s: min %d.%03d max %d.%03d mean %d.%03d sd %d.%03d", pcStatChannelNames[channel], mv.min / 1000, mv.min % 1000, mv.max / 1000, mv.max % 1000, mv.mean / 1000, mv.mean % 1000, mv.stddev / 1000, mv.stddev % 1000);
+		}
+	}
+
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvStatsRPi
+ * This command is the machine-readable variant of adc-stats for scripts on the Raspberry Pi.
+ * Like status-rpi it uses the command_order=1 flag to bypass a deactivated console_output.
+ *
+ * It outputs 15 lines "min max mean stddev" in millivolts: the 1-second, 1-minute and 1-hour windows,
+ * each with the channels Wide, Battery, mUSB, Output and VDD. A window, which hasn't been completed yet, outputs "0 0 0 0"
+ *
+ * ***/
+
+static portBASE_TYPE prvStatsRPi(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	uint8_t window;
+	uint8_t channel;
+	ADCStat_t mv;
+
+	(void) pcCommandString;
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	command_order = 1;
+
+	pcWriteBuffer[0] = 0x00;
+
+	for (window = 0; window < ADC_STATS_WINDOWS; window++)
+	{
+		for (channel = 0; channel < adcChannels; channel++)
+		{
+			if (adc_stats_valid[window] == 1)
+			{
+				prvGetStatMillivolts(window, channel, &mv);
+			}
+			else
+			{
+				memset(&mv, 0, sizeof(mv));
+			}
+			prvAppend(pcWriteBuffer, "%u %u %u %u\n", mv.min, mv.max, mv.mean, mv.stddev);
+		}
+	}
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvCapture
+ * This command outputs the state of the waveform capture (see capture.h)
+ *
+ * - "capture arm" clears the capture and waits for the next powerfailure
+ * - "capture dump" outputs the frozen capture for scripts (it bypasses a deactivated console_output like status-rpi):
+ *   the first line is "<values before trigger> <values after trigger> <interval in us>",
+ *   then every value follows as "<index> <Wide> <mUSB>" in millivolts,
+ *   the index is negative before the trigger.
+ *   As the output doesn't fit into the output buffer, it is returned in parts of captureDumpLines
+ *
+ * ***/
+
+#define captureDumpLines 16
+
+static portBASE_TYPE prvCapture(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	static uint16_t usDumpIndex = 0;
+	int8_t *pcParameter1;
+	BaseType_t xParameter1StringLength = 0;
+	uint16_t value[CAPTURE_CHANNELS];
+	uint8_t line;
+	uint8_t channel;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	pcWriteBuffer[0] = 0x00;
+
+	if (pcParameter1 != NULL && xParameter1StringLength == 4 && strncmp((char *) pcParameter1, "dump", 4) == 0 && capture_state == CAPTURE_FROZEN)
+	{
+		command_order = 1;
+
+		if (usDumpIndex == 0)
+		{
+			sprintf((char *) pcWriteBuffer, "%u %u %lu\n", capture_pre_count, CAPTURE_POST, (capture_end_time - capture_trigger_time) / CAPTURE_POST);
+		}
+
+		for (line = 0; line < captureDumpLines && usDumpIndex < capture_pre_count + CAPTURE_POST; line++, usDumpIndex++)
+		{
+			Capture_Get(usDumpIndex, value);
+			prvAppend(pcWriteBuffer, "%d", (int) usDumpIndex - capture_pre_count);
+			for (channel = 0; channel < CAPTURE_CHANNELS; channel++)
+			{
+				prvAppend(pcWriteBuffer, " %u", convertADCValue(capture_channel[channel], value[channel]));
+			}
+			prvAppend(pcWriteBuffer, "\n");
+		}
+
+		if (usDumpIndex < capture_pre_count + CAPTURE_POST)
+		{
+			return pdTRUE;
+		}
+
+		usDumpIndex = 0;
+		return pdFALSE;
+	}
+
+	if (pcParameter1 != NULL && xParameter1StringLength == 3 && strncmp((char *) pcParameter1, "arm", 3) == 0)
+	{
+		Capture_Arm();
+	}
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\nWaveform-Capture: ");
+
+	switch (capture_state)
+	{
+	case CAPTURE_ARMED:
+		prvAppend(pcWriteBuffer, "armed");
+		break;
+	case CAPTURE_TRIGGERED:
+		prvAppend(pcWriteBuffer, "triggered");
+		break;
+	case CAPTURE_FROZEN:
+		prvAppend(pcWriteBuffer, "captured (%u before / %u after the trigger, %lu us interval)", capture_pre_count, CAPTURE_POST, (capture_end_time - capture_trigger_time) / CAPTURE_POST);
+		break;
+	}
+
+	prvAppend(pcWriteBuffer, "\r\n****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvSleepStats
+ * This command outputs the residency of the tickless idle (see PreSleepProcessing in freertos.c),
+ * "sleep-stats reset" clears it
+ *
+ * ***/
+
+static portBASE_TYPE prvSleepStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	int8_t *pcParameter1;
+	BaseType_t xParameter1StringLength = 0;
+	uint32_t sleep_time;
+	uint32_t awake_time;
+	uint32_t total;
+	uint32_t residency = 0;
+
+	pcParameter1 = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameter1StringLength);
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	taskENTER_CRITICAL();
+	if (pcParameter1 != NULL && xParameter1StringLength == 5 && strncmp((char *) pcParameter1, "reset", 5) == 0)
+	{
+		lowpower_sleep_time = 0;
+		lowpower_awake_time = 0;
+		lowpower_sleep_counter = 0;
+	}
+	sleep_time = lowpower_sleep_time;
+	awake_time = lowpower_awake_time;
+	taskEXIT_CRITICAL();
+
+	/*** Residency in 0.1%, the sum is scaled down first, so the product fits into 32 bits ***/
+	total = (sleep_time >> 1) + (awake_time >> 1);
+	if (total >= 500)
+	{
+		residency = (sleep_time >> 1) / (total / 1000);
+		if (residency > 1000)
+		{
+			residency = 1000;
+		}
+	}
+
+	sprintf((char *) pcWriteBuffer, "****************************\r\n");
+	prvAppend(pcWriteBuffer, "Sleep-Residency: %lu.%lu %%\r\n", residency / 10, residency % 10);
+	prvAppend(pcWriteBuffer, "Sleep-Periods: %lu\r\n", lowpower_sleep_counter);
+	prvAppend(pcWriteBuffer, "****************************\r\n");
+
+	/* There is no more data to return after this single string, so return
+	 pdFALSE. */
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvSchedule
+ * This command outputs the schedule table (see schedule.h) or changes one of its entries:
+ *
+ * - schedule: lists the entries and the minutes until the next firing entry
+ * - schedule <index> <minute> <hour> <weekdays> <days> <action>
+ *   <minute> and <hour> are a number or * for every minute or hour,
+ *   <weekdays> are the digits of the weekdays (1: Monday .. 7: Sunday, e.g. 12345) or * for all,
+ *   <days> is the hexadecimal mask of the days of the month (bit 0: 1st day) or * for all,
+ *   <action> is wake, shutdown, interval or off (clears the entry)
+ *
+ * The list doesn't fit into the output buffer, so it is returned in two parts
+ *
+ * ***/
+
+static const char * const pcScheduleActions[] =
+{ "off", "wake", "shutdown", "interval" };
+
+static uint8_t prvParseScheduleField(const char *s, uint8_t max, uint8_t *value)
+{
+	uint32_t number = 0;
+
+	if (strcmp(s, "*") == 0)
+	{
+		*value = scheduleEvery;
+		return 1;
+	}
+
+	/*** Only digits are accepted, and the number is checked before it is narrowed to the field ***/
+	if (*s == 0)
+	{
+		return 0;
+	}
+
+	while (*s != 0)
+	{
+		if (*s < '0' || *s > '9' || number > max)
+		{
+			return 0;
+		}
+		number = number * 10 + (*s++ - '0');
+	}
+
+	if (number > max)
+	{
+		return 0;
+	}
+
+	*value = number;
+	return 1;
+}
+
+static portBASE_TYPE prvSchedule(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+	static uint8_t ucListIndex = 0;
+	int8_t *pcParameter[6];
+	BaseType_t xParameterStringLength[6];
+	ScheduleEntry_t entry;
+	const ScheduleEntry_t *listEntry;
+	uint8_t index;
+	uint8_t valid;
+	uint8_t day;
+	uint32_t now;
+	char *weekday;
+	char *digit;
+	uint8_t nibble;
+
+	for (index = 0; index < 6; index++)
+	{
+		xParameterStringLength[index] = 0;
+		pcParameter[index] = FreeRTOS_CLIGetParameter(pcCommandString, index + 1, &xParameterStringLength[index]);
+	}
+
+	configASSERT(pcWriteBuffer);
+
+	/* This function assumes the buffer length is adequate. */
+	(void) xWriteBufferLen;
+
+	pcWriteBuffer[0] = 0x00;
+
+	if (ucListIndex == 0 && pcParameter[5] != NULL)
+	{
+		for (index = 0; index < 6; index++)
+		{
+			pcParameter[index][xParameterStringLength[index]] = 0x00;
+		}
+
+		memset(&entry, 0xFF, sizeof(entry));
+		valid = prvParseScheduleField((char *) pcParameter[0], SCHEDULE_ENTRIES - 1, &index);
+		valid &= index < SCHEDULE_ENTRIES;
+		valid &= prvParseScheduleField((char *) pcParameter[1], 59, &entry.minute);
+		valid &= prvParseScheduleField((char *) pcParameter[2], 23, &entry.hour);
+
+		if (strcmp((char *) pcParameter[3], "*") == 0)
+		{
+			entry.weekdays = scheduleWeekdaysAll;
+		}
+		else
+		{
+			entry.weekdays = 0;
+			for (weekday = (char *) pcParameter[3]; *weekday != 0; weekday++)
+			{
+				if (*weekday < '1' || *weekday > '7')
+				{
+					valid = 0;
+					break;
+				}
+				entry.weekdays |= 1 << (*weekday - '1');
+			}
+		}
+
+		if (strcmp((char *) pcParameter[4], "*") == 0)
+		{
+			entry.days = scheduleDaysAll;
+		}
+		else
+		{
+			/*** Only hex digits are accepted, the mask is checked before it is shifted
+			 * and a mask without any day (0) is rejected, like an empty field ***/
+			entry.days = 0;
+			for (digit = (char *) pcParameter[4]; *digit != 0; digit++)
+			{
+				if (*digit >= '0' && *digit <= '9')
+				{
+					nibble = *digit - '0';
+				}
+				else if (*digit >= 'a' && *digit <= 'f')
+				{
+					nibble = *digit - 'a' + 10;
+				}
+				else if (*digit >= 'A' && *digit <= 'F')
+				{
+					nibble = *digit - 'A' + 10;
+				}
+				else
+				{
+					valid = 0;
+					break;
+				}
+
+				if (entry.days > (scheduleDaysAll >> 4))
+				{
+					valid = 0;
+					break;
+				}
+				entry.days = (entry.days << 4) | nibble;
+			}
+
+			if (entry.days == 0 || entry.days > scheduleDaysAll)
+			{
+				valid = 0;
+			}
+		}
+
+		for (entry.action = scheduleWake; entry.action <= scheduleInterval; entry.action++)
+		{
+			if (strcmp((char *) pcParameter[5], pcScheduleActions[entry.action]) == 0)
+			{
+				break;
+			}
+		}
+
+		if (strcmp((char *) pcParameter[5], pcScheduleActions[scheduleOff]) == 0)
+		{
+			memset(&entry, 0xFF, sizeof(entry));
+		}
+		else if (entry.action > scheduleInterval)
+		{
+			valid = 0;
+		}
+
+		if (valid)
+		{
+			Schedule_Set(index, &entry);
+		}
+		else
+		{
+			sprintf((char *) pcWriteBuffer, "Invalid schedule entry\r\n");
+		}
+	}
+
+	if (ucListIndex == 0)
+	{
+		prvAppend(pcWriteBuffer, "****************************\r\n");
+		if (schedule_next == scheduleNever)
+		{
+			prvAppend(pcWriteBuffer, "Next: none\r\n");
+		}
+		else
+		{
+			now = Schedule_Now();
+			prvAppend(pcWriteBuffer, "Next: in %lu min\r\n", schedule_next > now ? schedule_next - now : 0);
+		}
+	}
+
+	for (index = 0; index < SCHEDULE_ENTRIES / 2; index++, ucListIndex++)
+	{
+		listEntry = Schedule_Get(ucListIndex);
+
+		prvAppend(pcWriteBuffer, "%2d: ", ucListIndex);
+		if (listEntry->action < scheduleWake || listEntry->action > scheduleInterval)
+		{
+			prvAppend(pcWriteBuffer, "empty\r\n");
+			continue;
+		}
+
+		if (listEntry->hour == scheduleEvery)
+		{
+			prvAppend(pcWriteBuffer, "**:");
+		}
+		else
+		{
+			prvAppend(pcWriteBuffer, "%02d:", listEntry->hour);
+		}
+		if (listEntry->minute == scheduleEvery)
+		{
+			prvAppend(pcWriteBuffer, "** ");
+		}
+		else
+		{
+			prvAppend(pcWriteBuffer, "%02d ", listEntry->minute);
+		}
+
+		for (day = 0; day < 7; day++)
+		{
+			prvAppend(pcWriteBuffer, "%c", (listEntry->weekdays & (1 << day)) ? '1' + day : '-');
+		}
+
+		prvAppend(pcWriteBuffer, " %08lX %s\r\n", listEntry->days, pcScheduleActions[listEntry->action]);
+	}
+
+	if (ucListIndex < SCHEDULE_ENTRIES)
+	{
+		return pdTRUE;
+	}
+
+	prvAppend(pcWriteBuffer, "****************************\r\n");
+	ucListIndex = 0;
+
+	return pdFALSE;
+}
+
+/*-----------------------------------------------------------*/
+
+/*** ascii2int
+ * This is a help function to convert the input of the user into the correct format for storing into the associated variables
+ *
+ * ***/
+
+int ascii2int(const char* s)
+{
+	int i = 0;
+	while (*s != 0)
+	{
+		if (*s >= '0' && *s <= '9')
+		{
+			i = i * 10 + (*s - '0');
+			s++;
+		}
+		else
+			return 0;
+	}
+	return i;
+
+}
+
+/*-----------------------------------------------------------*/
+
+/*** prvUARTStartReception
+ * Programs the DMA1 Channel 3 to receive the characters of USART1 into the circular buffer ucRxBuffer.
+ * The channel is driven through its registers, so the USART1 and its DMA don't need HAL handles in the RAM.
+ * The reception runs from here on: a reception error doesn't stop the DMA (DDRE = 0) and a switch of
+ * the baudrate (uart_baud.c) only reprograms the baudrate register
+ *
+ * ***/
+
+static void prvUARTStartReception(void)
+{
+	usRxTail = 0;
+
+	DMA1_Channel3->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF3;
+
+	DMA1_Channel3->CPAR = (uint32_t) &USART1->RDR;
+	DMA1_Channel3->CMAR = (uint32_t) ucRxBuffer;
+	DMA1_Channel3->CNDTR = cmdRX_BUFFER_SIZE;
+	DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_EN;
+
+	/*** The DMA interrupt starts the next transfer of the transmit queue (uart_tx.c) and sets
+	 * the DMA request of the transmitter in the same register (CR3) as the reception here ***/
+	__disable_irq();
+	USART1->ICR = USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_NCF | USART_ICR_FECF;
+	USART1->CR3 |= USART_CR3_DMAR;
+	USART1->CR1 |= USART_CR1_IDLEIE;
+	__enable_irq();
+}
+
+/*** prvUARTGetChar
+ * Takes the next received character from the circular DMA receive buffer.
+ *
+ * ***/
+
+static BaseType_t prvUARTGetChar(int8_t *pcRxedChar)
+{
+	uint16_t usRxHead;
+
+	usRxHead = (cmdRX_BUFFER_SIZE - DMA1_Channel3->CNDTR) % cmdRX_BUFFER_SIZE;
+	if (usRxHead == usRxTail)
+	{
+		return pdFALSE;
+	}
+
+	*pcRxedChar = ucRxBuffer[usRxTail];
+	usRxTail = (usRxTail + 1) % cmdRX_BUFFER_SIZE;
+
+	return pdTRUE;
+}
+
+/*** vUARTCommandConsoleRxEvent
+ * Wakes the UART Console Task, is called by the idle line interrupt of USART1
+ * and by the half and complete interrupts of the DMA1 Channel 3 (stm32f0xx_it.c)
+ *
+ * ***/
+
+void vUARTCommandConsoleRxEvent(void)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if (xCommandConsoleTask != NULL)
+	{
+		vTaskNotifyGiveFromISR(xCommandConsoleTask, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
 }
 
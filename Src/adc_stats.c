@@ -0,0 +1,208 @@
+/*
+ * adc_stats.c
+ *
+ * ADC statistics of the StromPi3
+ *
+ * Please refer to adc_stats.h for the description of the windows.
+ */
+
+#include "adc_stats.h"
+#include "stm32f0xx_hal.h"
+
+/*** Accumulator of the 1-second window
+ * 4095^2 summed up over a second of continuous conversion doesn't fit into 32 bits.
+ * All channels are added together, so the number of values is kept once in secondCount ***/
+typedef struct
+{
+	uint16_t min;
+	uint16_t max;
+	uint32_t sum;
+	uint64_t sumsq;
+} ADCStatSecond_t;
+
+/*** Accumulator of the 1-minute and 1-hour windows
+ * Sums up to 60 means and mean squares of the completed shorter windows,
+ * the number of windows is kept once in minuteCount and hourCount ***/
+typedef struct
+{
+	uint16_t min;
+	uint16_t max;
+	uint32_t sum;
+	uint32_t sumsq;
+} ADCStatAggregate_t;
+
+ADCStat_t adc_stats[ADC_STATS_WINDOWS][adcChannels];
+uint8_t adc_stats_valid[ADC_STATS_WINDOWS];
+
+static ADCStatSecond_t second[adcChannels];
+static ADCStatAggregate_t minute[adcChannels];
+static ADCStatAggregate_t hour[adcChannels];
+static uint16_t secondCount;
+static uint8_t minuteCount;
+static uint8_t hourCount;
+static uint32_t secondStart;
+
+/*** isqrt
+ * Integer square root by bitwise approximation, the Cortex-M0 has no FPU ***/
+
+static uint16_t isqrt(uint32_t x)
+{
+	uint32_t result = 0;
+	uint32_t bit = 1UL << 30;
+
+	while (bit > x)
+	{
+		bit >>= 2;
+	}
+
+	while (bit != 0)
+	{
+		if (x >= result + bit)
+		{
+			x -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else
+		{
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return result;
+}
+
+/*** Adds a completed window (min, max, mean and variance) to the accumulator of the next longer window ***/
+
+static void addAggregate(ADCStatAggregate_t *aggregate, uint8_t count, uint16_t min, uint16_t max, uint16_t mean, uint32_t variance)
+{
+	if (count == 0 || min < aggregate->min)
+	{
+		aggregate->min = min;
+	}
+	if (count == 0 || max > aggregate->max)
+	{
+		aggregate->max = max;
+	}
+
+	aggregate->sum += mean;
+	aggregate->sumsq += variance + (uint32_t) mean * mean;
+}
+
+/*** Completes the window of the aggregate into stat and returns the variance ***/
+
+static uint32_t closeAggregate(ADCStatAggregate_t *aggregate, uint8_t count, ADCStat_t *stat)
+{
+	uint32_t mean = aggregate->sum / count;
+	uint32_t meansq = aggregate->sumsq / count;
+	uint32_t variance = meansq > mean * mean ? meansq - mean * mean : 0;
+
+	stat->min = aggregate->min;
+	stat->max = aggregate->max;
+	stat->mean = mean;
+	stat->stddev = isqrt(variance);
+
+	aggregate->sum = 0;
+	aggregate->sumsq = 0;
+
+	return variance;
+}
+
+static void closeSecond(void)
+{
+	uint8_t channel;
+	uint32_t mean;
+	uint32_t meansq;
+	uint32_t variance;
+	ADCStatSecond_t *acc;
+	ADCStat_t *stat;
+
+	if (secondCount == 0)
+	{
+		return;
+	}
+
+	for (channel = 0; channel < adcChannels; channel++)
+	{
+		acc = &second[channel];
+
+		mean = acc->sum / secondCount;
+		meansq = (uint32_t) (acc->sumsq / secondCount);
+		variance = meansq > mean * mean ? meansq - mean * mean : 0;
+
+		adc_stats[ADC_STATS_SECOND][channel].min = acc->min;
+		adc_stats[ADC_STATS_SECOND][channel].max = acc->max;
+		adc_stats[ADC_STATS_SECOND][channel].mean = mean;
+		adc_stats[ADC_STATS_SECOND][channel].stddev = isqrt(variance);
+
+		addAggregate(&minute[channel], minuteCount, acc->min, acc->max, mean, variance);
+
+		acc->sum = 0;
+		acc->sumsq = 0;
+
+		if (minuteCount == 59)
+		{
+			stat = &adc_stats[ADC_STATS_MINUTE][channel];
+			variance = closeAggregate(&minute[channel], 60, stat);
+			addAggregate(&hour[channel], hourCount, stat->min, stat->max, stat->mean, variance);
+
+			if (hourCount == 59)
+			{
+				closeAggregate(&hour[channel], 60, &adc_stats[ADC_STATS_HOUR][channel]);
+			}
+		}
+	}
+
+	secondCount = 0;
+	adc_stats_valid[ADC_STATS_SECOND] = 1;
+
+	minuteCount++;
+	if (minuteCount == 60)
+	{
+		minuteCount = 0;
+		adc_stats_valid[ADC_STATS_MINUTE] = 1;
+
+		hourCount++;
+		if (hourCount == 60)
+		{
+			hourCount = 0;
+			adc_stats_valid[ADC_STATS_HOUR] = 1;
+		}
+	}
+}
+
+/*** ADCStats_Update
+ * Adds the filtered ADC-Values of all channels to the 1-second window,
+ * is called from the ADC DMA interrupt for every half-buffer ***/
+
+void ADCStats_Update(const uint16_t *value)
+{
+	uint8_t channel;
+	uint32_t now = HAL_GetTick();
+	ADCStatSecond_t *acc;
+
+	if (now - secondStart >= 1000)
+	{
+		closeSecond();
+		secondStart = now;
+	}
+
+	for (channel = 0; channel < adcChannels; channel++)
+	{
+		acc = &second[channel];
+
+		if (secondCount == 0 || value[channel] < acc->min)
+		{
+			acc->min = value[channel];
+		}
+		if (secondCount == 0 || value[channel] > acc->max)
+		{
+			acc->max = value[channel];
+		}
+
+		acc->sum += value[channel];
+		acc->sumsq += (uint32_t) value[channel] * value[channel];
+	}
+
+	secondCount++;
+}
@@ -0,0 +1,100 @@
+/*
+ * capture.c
+ *
+ * Waveform capture of the StromPi3
+ *
+ * Please refer to capture.h for the description of the capture.
+ */
+
+#include "capture.h"
+#include "latency.h"
+
+volatile uint8_t capture_state;
+const uint8_t capture_channel[CAPTURE_CHANNELS] = { 0, 2 };
+uint8_t capture_pre_count;
+uint32_t capture_trigger_time;
+uint32_t capture_end_time;
+
+static uint8_t captureBuffer[CAPTURE_LENGTH][CAPTURE_CHANNELS];
+static uint8_t captureIndex;
+static uint8_t captureTriggerIndex;
+static uint8_t capturePostCount;
+
+/*** Capture_Sample
+ * Writes the filtered ADC-Values into the ring buffer,
+ * is called from the ADC DMA interrupt for every half-buffer ***/
+
+void Capture_Sample(const uint16_t *value)
+{
+	uint8_t channel;
+
+	if (capture_state == CAPTURE_FROZEN)
+	{
+		return;
+	}
+
+	for (channel = 0; channel < CAPTURE_CHANNELS; channel++)
+	{
+		captureBuffer[captureIndex][channel] = value[capture_channel[channel]] >> CAPTURE_SHIFT;
+	}
+
+	captureIndex++;
+	if (captureIndex == CAPTURE_LENGTH)
+	{
+		captureIndex = 0;
+	}
+
+	if (capture_state == CAPTURE_ARMED)
+	{
+		if (capture_pre_count < CAPTURE_PRE)
+		{
+			capture_pre_count++;
+		}
+	}
+	else
+	{
+		capturePostCount++;
+		if (capturePostCount == CAPTURE_POST)
+		{
+			capture_end_time = Latency_Now();
+			capture_state = CAPTURE_FROZEN;
+		}
+	}
+}
+
+/*** Capture_Trigger
+ * Is called from the ADC-Watchdog Callback, only the first powerfailure after arming is captured ***/
+
+void Capture_Trigger(void)
+{
+	if (capture_state != CAPTURE_ARMED)
+	{
+		return;
+	}
+
+	capture_trigger_time = Latency_Now();
+	captureTriggerIndex = captureIndex;
+	capturePostCount = 0;
+	capture_state = CAPTURE_TRIGGERED;
+}
+
+void Capture_Arm(void)
+{
+	capture_pre_count = 0;
+	capture_state = CAPTURE_ARMED;
+}
+
+/*** Capture_Get
+ * Returns the ADC-Values (restored to 12 bits) of a frozen capture in chronological order:
+ * index 0 is the oldest value before the trigger, index capture_pre_count is the first value after the trigger ***/
+
+void Capture_Get(uint16_t index, uint16_t *value)
+{
+	uint8_t channel;
+	uint16_t position = (captureTriggerIndex + CAPTURE_LENGTH - capture_pre_count + index) % CAPTURE_LENGTH;
+
+	for (channel = 0; channel < CAPTURE_CHANNELS; channel++)
+	{
+		value[channel] = (captureBuffer[position][channel] << CAPTURE_SHIFT) | (1 << (CAPTURE_SHIFT - 1));
+	}
+}
@@ -51,12 +51,18 @@
 #include "task.h"
 
 /* USER CODE BEGIN Includes */     
+#include "latency.h"
 
 /* USER CODE END Includes */
 
 /* Variables -----------------------------------------------------------------*/
 
 /* USER CODE BEGIN Variables */
+static uint32_t sleepTimestamp;
+static uint32_t wakeTimestamp;
+static int32_t sleepTickRemainder;
+
+extern __IO uint32_t uwTick;
 
 /* USER CODE END Variables */
 
@@ -69,6 +75,9 @@
 /* Hook prototypes */
 void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName);
 
+/* GetIdleTaskMemory prototype (linked to static allocation support) */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize );
+
 /* USER CODE BEGIN 4 */
 __weak void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName)
 {
@@ -78,6 +87,79 @@ __weak void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTask
 }
 /* USER CODE END 4 */
 
+/* USER CODE BEGIN GET_IDLE_TASK_MEMORY */
+static StaticTask_t xIdleTaskTCBBuffer;
+static StackType_t xIdleStack[configIDLE_TASK_STACK_SIZE];
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize )
+{
+  *ppxIdleTaskTCBBuffer = &xIdleTaskTCBBuffer;
+  *ppxIdleTaskStackBuffer = &xIdleStack[0];
+  *pulIdleTaskStackSize = configIDLE_TASK_STACK_SIZE;
+  /* place for user code */
+}
+/* USER CODE END GET_IDLE_TASK_MEMORY */
+
+/* USER CODE BEGIN PREPOSTSLEEP */
+
+/*** PreSleepProcessing
+ * Is called by the tickless idle with disabled interrupts right before the WFI instruction.
+ * The STOP mode isn't usable, because it would stop the HSE (which also clocks the RTC), the PLL and the ADC,
+ * so the core only waits in the SLEEP mode: every enabled interrupt wakes it up (ADC-Watchdog, ADC DMA,
+ * USART1 RX, TIM16, RTC) and the PLL keeps running, so no clock has to be restored.
+ *
+ * The HAL timebase (TIM14) would wake the core every millisecond, so its interrupt is suspended while asleep
+ * and PostSleepProcessing adds the milliseconds asleep (measured by TIM2) to the HAL tick, so the restore
+ * stable time and the HAL timeouts keep their length. The remainder below a millisecond is carried to the next sleep.
+ * The ADC DMA still wakes the core at every half-buffer, because the failover hysteresis, the slope estimator,
+ * the statistics and the capture need every filtered value. In the continuous mode (adc_rate 0) this is every
+ * few hundred microseconds, so the core only sleeps noticeably with the timer-triggered acquisition (adc_rate > 0) ***/
+
+void PreSleepProcessing(uint32_t *ulExpectedIdleTime)
+{
+	(void) ulExpectedIdleTime;
+
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	HAL_SuspendTick();
+
+	sleepTimestamp = Latency_Now();
+	if (lowpower_sleep_counter > 0)
+	{
+		lowpower_awake_time += sleepTimestamp - wakeTimestamp;
+	}
+}
+
+void PostSleepProcessing(uint32_t *ulExpectedIdleTime)
+{
+	(void) ulExpectedIdleTime;
+
+	wakeTimestamp = Latency_Now();
+	lowpower_sleep_time += wakeTimestamp - sleepTimestamp;
+	lowpower_sleep_counter++;
+
+	/*** A pending update of TIM14 is counted by its interrupt after the resume ***/
+	sleepTickRemainder += wakeTimestamp - sleepTimestamp;
+	if (TIM14->SR & TIM_SR_UIF)
+	{
+		sleepTickRemainder -= 1000;
+	}
+	if (sleepTickRemainder >= 1000)
+	{
+		uwTick += sleepTickRemainder / 1000;
+		sleepTickRemainder %= 1000;
+	}
+	HAL_ResumeTick();
+
+	if (lowpower_sleep_time >= lowpowerAgingLimit || lowpower_awake_time >= lowpowerAgingLimit)
+	{
+		lowpower_sleep_time >>= 1;
+		lowpower_awake_time >>= 1;
+	}
+}
+
+/* USER CODE END PREPOSTSLEEP */
+
 /* USER CODE BEGIN Application */
      
 /* USER CODE END Application */
@@ -0,0 +1,66 @@
+/*
+ * latency.c
+ *
+ * Failover latency instrumentation of the StromPi3
+ *
+ * Please refer to latency.h for the description of the measured intervals.
+ */
+
+#include <string.h>
+#include "latency.h"
+
+volatile uint32_t latency_awd_timestamp;
+volatile uint32_t latency_switch_timestamp;
+volatile uint8_t latency_task_pending;
+
+LatencyStat_t latency_switch;
+LatencyStat_t latency_task;
+uint32_t latency_boot_tick;
+uint32_t latency_boot_timestamp;
+
+LatencyStat_t latency_loop_execution;
+LatencyStat_t latency_loop_jitter;
+
+/*** Latency_Record
+ * Adds a measured latency to the statistics.
+ * The Cortex-M0 has no CLZ instruction, so the histogram bin is found by shifting ***/
+
+void Latency_Record(LatencyStat_t *stat, uint32_t us)
+{
+	uint8_t bin = 0;
+
+	while (bin < (LATENCY_HIST_BINS - 1) && (us >> (2 * bin)) != 0)
+	{
+		bin++;
+	}
+
+	if (stat->count == 0 || us < stat->min)
+	{
+		stat->min = us;
+	}
+	if (us > stat->max)
+	{
+		stat->max = us;
+	}
+
+	stat->sum += us;
+	stat->count++;
+
+	if (stat->hist[bin] != 0xFFFF)
+	{
+		stat->hist[bin]++;
+	}
+}
+
+void Latency_Reset(void)
+{
+	memset(&latency_switch, 0, sizeof(latency_switch));
+	memset(&latency_task, 0, sizeof(latency_task));
+	latency_task_pending = 0;
+}
+
+void Latency_ResetLoop(void)
+{
+	memset(&latency_loop_execution, 0, sizeof(latency_loop_execution));
+	memset(&latency_loop_jitter, 0, sizeof(latency_loop_jitter));
+}
@@ -112,6 +112,15 @@
 #include "cmsis_os.h"
 
 /* USER CODE BEGIN Includes */
+#include "latency.h"
+#include "adc_stats.h"
+#include "capture.h"
+#include "schedule.h"
+#include "power_arbiter.h"
+#include "slope.h"
+#include "uart_tx.h"
+#include "uart_baud.h"
+#include "protocol.h"
 
 /*** The following variables are needed for initialization of the STM32-HAL System ***/
 
@@ -119,13 +128,12 @@
 
 /* Private variables ---------------------------------------------------------*/
 ADC_HandleTypeDef hadc;
-DMA_HandleTypeDef hdma_adc;
 
 RTC_HandleTypeDef hrtc;
 
-UART_HandleTypeDef huart1;
-
 osThreadId defaultTaskHandle;
+uint32_t defaultTaskBuffer[ mainTaskStackSize ];
+osStaticThreadDef_t defaultTaskControlBlock;
 
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
@@ -140,15 +148,29 @@ static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
 static void MX_ADC_Init(void);
 static void MX_RTC_Init(void);
+static void MX_TIM2_Init(void);
+static void MX_TIM3_Init(void);
+static void MX_TIM16_Init(void);
 static void MX_USART1_UART_Init(void);
 void StartDefaultTask(void const * argument);
 static void MX_NVIC_Init(void);
+static void startProtection(void);
 
 /* USER CODE BEGIN PFP */
 /* Private function prototypes -----------------------------------------------*/
 
 extern void vUARTCommandConsoleStart(void);
 
+/*** End of the RAM, from the linker script ***/
+extern uint8_t _estack;
+
+static void resetRestoreState(void);
+static void restorePrimary(void);
+static void processShutdownFlags(void);
+static void waitMainEvents(TickType_t deadline);
+static HAL_StatusTypeDef startADC(void);
+static HAL_StatusTypeDef stopADC(void);
+
 /* USER CODE END PFP */
 
 /* USER CODE BEGIN 0 */
@@ -158,13 +180,13 @@ extern void vUARTCommandConsoleStart(void);
 RTC_DateTypeDef sdatestructure;
 RTC_TimeTypeDef stimestructure;
 
-/*** Here are defined the warning messages which are sent through the serial interface ***/
+/*** Here are defined the warning messages which are sent through the serial interface, they are kept in the flash ***/
 
-uint8_t shutdownMessage[] = "xxxShutdownRaspberryPixxx\n\r";
+const uint8_t shutdownMessage[] = "xxxShutdownRaspberryPixxx\n\r";
 
-uint8_t powerfailMessage[] = "xxx--StromPiPowerfail--xxx\n\r";
+const uint8_t powerfailMessage[] = "xxx--StromPiPowerfail--xxx\n\r";
 
-uint8_t powerBackMessage[] = "xxx--StromPiPowerBack--xxx\n\r";
+const uint8_t powerBackMessage[] = "xxx--StromPiPowerBack--xxx\n\r";
 
 /*** FreeRTOS Hook for Debug-Purposes ***/
 
@@ -218,6 +240,19 @@ int main(void)
 	wakeup_time_enable = *(uint8_t *) wakeup_time_enable_FlashAdress;
 	wakeup_time = *(uint16_t *) wakeup_time_FlashAdress;
 	wakeupweekend_enable = *(uint8_t *) wakeupweekend_enable_FlashAdress;
+	minUSB_fail = *(uint16_t *) minUSB_fail_FlashAdress;
+	minUSB_restore = *(uint16_t *) minUSB_restore_FlashAdress;
+	minWide_fail = *(uint16_t *) minWide_fail_FlashAdress;
+	minWide_restore = *(uint16_t *) minWide_restore_FlashAdress;
+	restore_stable_time = *(uint16_t *) restore_stable_time_FlashAdress;
+	slope_mode = *(uint8_t *) slope_mode_FlashAdress;
+	slope_rate = *(uint16_t *) slope_rate_FlashAdress;
+	adc_rate = *(uint16_t *) adc_rate_FlashAdress;
+	adc_autooff = *(uint8_t *) adc_autooff_FlashAdress;
+	loop_period = *(uint16_t *) loop_period_FlashAdress;
+
+	/*** The parameters from 29 on are not part of older configurations, so blank values are replaced by the defaults ***/
+	validateConfig();
 
 
 	/*** Only for manufacturing | Checks if the Flash Area of the STM32F031 is blank - in this case it preprogramm it with a default configuration ***/
@@ -285,6 +320,9 @@ int main(void)
 	MX_GPIO_Init();
 	MX_DMA_Init();
 	MX_RTC_Init();
+	MX_TIM2_Init();
+	MX_TIM3_Init();
+	MX_TIM16_Init();
 
 	/* Initialize interrupts */
 	MX_NVIC_Init();
@@ -317,6 +355,8 @@ int main(void)
 		Error_Handler();
 	}
 
+	Schedule_Reschedule();
+
 	/*********************************************************************************/
 
 	/*** Activates Powerpath of the configured primary source ***/
@@ -334,25 +374,25 @@ int main(void)
 	 *  So for the initial boot process the primary source is selected
 	 */
 
-	if (modus == 1 || modus == 3)
-	{
-		Power_USB();
-	}
-	else if (modus == 2 || modus == 4)
-	{
-		Power_Wide();
-	}
-	else if (modus == 5)
+	if (modus == 5)
 	{
 		threeStageMode = 1;
 		modus = 1;
-		Power_USB();
 	}
 	else if (modus == 6)
 	{
 		threeStageMode = 2;
 		modus = 2;
-		Power_Wide();
+	}
+
+	Power_Source(PowerArbiter_Primary(modus));
+
+	/*** Fast boot: the failover protection is armed before the scheduler starts.
+	 * The serial interface is initialized here too, so its temporary HAL handle isn't part of the stack of the main Task ***/
+	if (initstart == 0)
+	{
+		startProtection();
+		MX_USART1_UART_Init();
 	}
 
 	/*********************************************************************************/
@@ -377,7 +417,7 @@ int main(void)
 
 	/* Create the thread(s) */
 	/* definition and creation of defaultTask */
-	osThreadDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, 64);
+	osThreadStaticDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, mainTaskStackSize, defaultTaskBuffer, &defaultTaskControlBlock);
 	defaultTaskHandle = osThreadCreate(osThread(defaultTask), NULL);
 
 	/* USER CODE BEGIN RTOS_THREADS */
@@ -474,14 +514,26 @@ void SystemClock_Config(void)
 static void MX_NVIC_Init(void)
 {
 	/* ADC1_IRQn interrupt configuration */
-	HAL_NVIC_SetPriority(ADC1_IRQn, 3, 0);
+	HAL_NVIC_SetPriority(ADC1_IRQn, 0, 0);
 	HAL_NVIC_EnableIRQ(ADC1_IRQn);
+	/* ADC_Deferred_IRQn (TIM17_IRQn) interrupt configuration */
+	HAL_NVIC_SetPriority(ADC_Deferred_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(ADC_Deferred_IRQn);
 	/* USART1_IRQn interrupt configuration */
 	HAL_NVIC_SetPriority(USART1_IRQn, 3, 0);
 	HAL_NVIC_EnableIRQ(USART1_IRQn);
 	/* DMA1_Channel1_IRQn interrupt configuration */
 	HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 3, 0);
 	HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+	/* DMA1_Channel2_3_IRQn interrupt configuration */
+	HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+	/* TIM16_IRQn interrupt configuration */
+	HAL_NVIC_SetPriority(TIM16_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(TIM16_IRQn);
+	/* RTC_IRQn interrupt configuration */
+	HAL_NVIC_SetPriority(RTC_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(RTC_IRQn);
 }
 
 /* ADC init function */
@@ -572,6 +624,8 @@ static void MX_ADC_Init(void)
 static void MX_RTC_Init(void)
 {
 
+	RTC_AlarmTypeDef sAlarm;
+
 	/**Initialize RTC Only
 	 */
 	hrtc.Instance = RTC;
@@ -586,12 +640,124 @@ static void MX_RTC_Init(void)
 		_Error_Handler(__FILE__, __LINE__);
 	}
 
+	/**Enable the Alarm A
+	 * Only the seconds are compared, so the alarm fires at every full minute for the Alarm_Handler()
+	 */
+	sAlarm.AlarmTime.Hours = 0;
+	sAlarm.AlarmTime.Minutes = 0;
+	sAlarm.AlarmTime.Seconds = 0;
+	sAlarm.AlarmTime.SubSeconds = 0;
+	sAlarm.AlarmTime.TimeFormat = RTC_HOURFORMAT12_AM;
+	sAlarm.AlarmTime.DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
+	sAlarm.AlarmTime.StoreOperation = RTC_STOREOPERATION_RESET;
+	sAlarm.AlarmMask = RTC_ALARMMASK_DATEWEEKDAY | RTC_ALARMMASK_HOURS | RTC_ALARMMASK_MINUTES;
+	sAlarm.AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_ALL;
+	sAlarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
+	sAlarm.AlarmDateWeekDay = 1;
+	sAlarm.Alarm = RTC_ALARM_A;
+	if (HAL_RTC_SetAlarm_IT(&hrtc, &sAlarm, RTC_FORMAT_BIN) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+}
+
+/* TIM2 init function */
+static void MX_TIM2_Init(void)
+{
+
+	/*** The handle is only needed for the initialization (zeroed for its state HAL_TIM_STATE_RESET),
+	 * TIM2 is read through its registers (Latency_Now) ***/
+	TIM_HandleTypeDef htim2 = { 0 };
+
+	/**TIM2 is used as free running 32-bit counter with 1MHz
+	 * for the timestamps of the failover latency measurement (latency.c)
+	 */
+	htim2.Instance = TIM2;
+	htim2.Init.Prescaler = (HAL_RCC_GetPCLK1Freq() / 1000000) - 1;
+	htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim2.Init.Period = 0xFFFFFFFF;
+	htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&htim2) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+	if (HAL_TIM_Base_Start(&htim2) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+}
+
+/* TIM3 init function */
+static void MX_TIM3_Init(void)
+{
+
+	TIM_MasterConfigTypeDef sMasterConfig;
+
+	/*** The handle is only needed for the initialization, configureADCMode() uses the registers of TIM3 ***/
+	TIM_HandleTypeDef htim3 = { 0 };
+
+	/**TIM3 triggers the ADC scans through its TRGO in the timer-triggered ADC acquisition mode,
+	 * the period is set by configureADCMode()
+	 */
+	htim3.Instance = TIM3;
+	htim3.Init.Prescaler = (HAL_RCC_GetPCLK1Freq() / adcTriggerClock) - 1;
+	htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim3.Init.Period = (adcTriggerClock / adc_rate_max) - 1;
+	htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&htim3) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+	sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+	sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+	if (HAL_TIMEx_MasterConfigSynchronization(&htim3, &sMasterConfig) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+}
+
+/* TIM16 init function */
+static void MX_TIM16_Init(void)
+{
+
+	/*** The handle is only needed for the initialization, the power-back debounce
+	 * and TIM16_IRQHandler() use the registers of TIM16 ***/
+	TIM_HandleTypeDef htim16 = { 0 };
+
+	/**TIM16 is used as one-shot timer with 1kHz
+	 * for the debouncing of the power-back ADC-Watchdog interrupt
+	 */
+	htim16.Instance = TIM16;
+	htim16.Init.Prescaler = (HAL_RCC_GetPCLK1Freq() / 1000) - 1;
+	htim16.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim16.Init.Period = restore_stable_time_default;
+	htim16.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim16.Init.RepetitionCounter = 0;
+	htim16.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&htim16) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+	htim16.Instance->CR1 |= TIM_CR1_OPM;
+
 }
 
 /* USART1 init function */
 static void MX_USART1_UART_Init(void)
 {
 
+	/*** The handle is only needed for the initialization, the transmit queue (uart_tx.c), the DMA reception
+	 * of the console (UART_CLI.c) and the baudrate negotiation (uart_baud.c) use the registers of USART1 ***/
+	UART_HandleTypeDef huart1 = { 0 };
+
 	huart1.Instance = USART1;
 	huart1.Init.BaudRate = 38400;
 	huart1.Init.WordLength = UART_WORDLENGTH_8B;
@@ -719,8 +885,33 @@ void Config_Reset_Pin_Output(void)
  * 		- Power_Wide() activates the PowerPath of the WideRange StepDownConverter
  * 		- Power_Bat() deactivates the charging circuit and activates the PowerPath of the Battery
  * 		- Power_Off() deactivates all Powerpathes so the Raspberry Pi turns off completely
+ * 		- Power_Source() activates the PowerPath of a source selected by the power_arbiter
  */
 
+void Power_Source(uint8_t source)
+{
+	switch (source)
+	{
+	case powerSourceUSB:
+		Power_USB();
+		break;
+	case powerSourceWide:
+		Power_Wide();
+		break;
+	case powerSourceBat:
+		Power_Bat();
+		powerBat_flag = 1;
+		break;
+	}
+}
+
+/*** Sources, which have been stable above their restore threshold for the minimum stable time ***/
+
+static uint8_t availableSources(void)
+{
+	return (restoreStable_USB() ? powerAvailableUSB : 0) | (restoreStable_Wide() ? powerAvailableWide : 0);
+}
+
 void Power_USB(void)
 {
 	output_status = 1;
@@ -780,6 +971,47 @@ void Power_Off(void)
 	HAL_GPIO_WritePin(BOOST_EN_GPIO_Port, BOOST_EN_Pin, GPIO_PIN_SET);
 	HAL_GPIO_WritePin(CTRL_VUSB_GPIO_Port, CTRL_VUSB_Pin, GPIO_PIN_RESET);
 }
+/*********************************************************************************/
+/*
+ * Precomputed PowerPath for the fast failover
+ *
+ * The GPIOA BSRR words below set the same pin levels as Power_USB(), Power_Wide() and Power_Bat()
+ * (set bits in the lower halfword, reset bits in the upper halfword), so the ADC1 interrupt vector
+ * can switch all MOSFETs of the backup source at once with a single register store.
+ * updateFailoverPath() selects the word of the backup source of the actual mode and includes the
+ * L7987 pin if the power save mode is enabled.
+ */
+
+#define BSRR_SET(pin)	((uint32_t) (pin))
+#define BSRR_RESET(pin)	((uint32_t) (pin) << 16)
+
+#define failoverBSRR_USB	(BSRR_SET(CTRL_VUSB_Pin) | BSRR_RESET(CTRL_VREG5_Pin) | BSRR_SET(BOOST_EN_Pin))
+#define failoverBSRR_Wide	(BSRR_RESET(CTRL_VUSB_Pin) | BSRR_SET(CTRL_VREG5_Pin) | BSRR_SET(BOOST_EN_Pin))
+#define failoverBSRR_Bat	(BSRR_RESET(CTRL_VUSB_Pin) | BSRR_RESET(CTRL_VREG5_Pin) | BSRR_RESET(BOOST_EN_Pin))
+
+static const uint32_t failoverBSRR[4] =
+{ 0, failoverBSRR_USB, failoverBSRR_Wide, failoverBSRR_Bat };
+
+void updateFailoverPath(void)
+{
+	uint32_t bsrr = 0;
+	uint8_t source;
+
+	if (fastFailover == 1)
+	{
+		source = PowerArbiter_Backup(modus);
+		bsrr = failoverBSRR[source];
+
+		/*** The L7987 is only running, when the backup source is Wide ***/
+		if (bsrr != 0 && powersave_enable == 1)
+		{
+			bsrr |= (source == powerSourceWide) ? BSRR_SET(CTRL_L7987_Pin) : BSRR_RESET(CTRL_L7987_Pin);
+		}
+	}
+
+	failover_bsrr = bsrr;
+}
+
 /*********************************************************************************/
 
 /*** Functions to output the warning message, when the state of the StromPi3 have changes
@@ -790,9 +1022,16 @@ void Power_Off(void)
  * 		- PowerBack() sends a message when the primary voltage source comes back
  * 		- PowerfailWarning() sends the warning when the primary voltage source fails but its message doesn't shutdown the RPi
  *
+ * 		The messages are queued into the event lane of the transmit queue (uart_tx.h),
+ * 		so the main Task isn't held while they are sent and they go before any pending output of the serial console,
+ * 		followed by an event frame of the binary protocol (protocol.h), if the script has turned them on
+ *
  * 																							  ***/
 void ShutdownRPi(void)
 {
+	/*** The shutdown message and the scripts after the next boot use the default baudrate ***/
+	UartBaud_Default();
+
 	if (serialLessMode)
 	{
 		Config_Reset_Pin_Output();
@@ -801,19 +1040,57 @@ void ShutdownRPi(void)
 	}
 	else
 	{
-		HAL_UART_Transmit(&huart1, (uint8_t *) shutdownMessage, sizeof(shutdownMessage), sizeof(shutdownMessage));
+		UartTx_Event(shutdownMessage, sizeof(shutdownMessage));
+		Protocol_Event(protocolEventShutdown);
 	}
 }
 
 void PowerBack(void)
 {
-	HAL_UART_Transmit(&huart1, (uint8_t *) powerBackMessage, sizeof(powerBackMessage), sizeof(powerBackMessage));
+	UartTx_Event(powerBackMessage, sizeof(powerBackMessage));
+	Protocol_Event(protocolEventPowerBack);
 }
 
 void PowerfailWarning(void)
 {
-	HAL_UART_Transmit(&huart1, (uint8_t *) powerfailMessage, sizeof(powerfailMessage), sizeof(powerfailMessage));
-	vTaskDelay(1 * 1000);
+	UartTx_Event(powerfailMessage, sizeof(powerfailMessage));
+	Protocol_Event(protocolEventPowerfail);
+}
+
+/*********************************************************************************/
+
+/*** startADC / stopADC
+ * Start and stop the ADC with the transfer of its conversions into the circular adcDMABuffer.
+ * The DMA1 Channel 1 is driven through its registers, so it doesn't need a HAL handle in the RAM,
+ * its interrupt (stm32f0xx_it.c) calls HAL_ADC_ConvHalfCpltCallback() and HAL_ADC_ConvCpltCallback() ***/
+
+static HAL_StatusTypeDef startADC(void)
+{
+	DMA1_Channel1->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF1;
+
+	DMA1_Channel1->CPAR = (uint32_t) &ADC1->DR;
+	DMA1_Channel1->CMAR = (uint32_t) adcDMABuffer;
+	DMA1_Channel1->CNDTR = adcDMABufferSize;
+	DMA1_Channel1->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_EN;
+
+	/*** DMA requests in the circular mode (DMACFG, DMAContinuousRequests of MX_ADC_Init()) ***/
+	hadc.Instance->CFGR1 |= ADC_CFGR1_DMAEN | ADC_CFGR1_DMACFG;
+
+	return HAL_ADC_Start(&hadc);
+}
+
+static HAL_StatusTypeDef stopADC(void)
+{
+	if (HAL_ADC_Stop(&hadc) != HAL_OK)
+	{
+		return HAL_ERROR;
+	}
+
+	hadc.Instance->CFGR1 &= ~ADC_CFGR1_DMAEN;
+	DMA1_Channel1->CCR = 0;
+
+	return HAL_OK;
 }
 
 /*********************************************************************************/
@@ -831,11 +1108,13 @@ void PowerfailWarning(void)
 void reconfigureWatchdog()
 {
 
-	if (HAL_ADC_Stop_DMA(&hadc) != HAL_OK)
+	if (stopADC() != HAL_OK)
 	{
 		return 0;
 	}
 
+	configureADCMode();
+
 	if (modus == 1 || modus == 3)
 	{
 		configureAWD_USB();
@@ -845,14 +1124,51 @@ void reconfigureWatchdog()
 		configureAWD_Wide();
 	}
 
+	updateFailoverPath();
+
 	HAL_ADCEx_Calibration_Start(&hadc);
 
-	if (HAL_ADC_Start_DMA(&hadc, (uint32_t*) rawValue, 5) != HAL_OK)
+	if (startADC() != HAL_OK)
 	{
 		return 0;
 	}
 }
 
+/*** startProtection
+ * Fast boot: starts the ADC, its DMA and the ADC-Watchdog of the primary source in main() before the scheduler,
+ * so the PowerPath enabled at the start is protected within milliseconds after the reset.
+ * The interrupts only notify the main Task, once it has been created.
+ * The time-to-protection is recorded into latency_boot_tick and latency_boot_timestamp (failover-latency command) ***/
+
+static void startProtection(void)
+{
+	uint8_t primary = PowerArbiter_Primary(modus);
+
+	MX_ADC_Init();
+	configureADCMode();
+
+	if (primary == powerSourceUSB)
+	{
+		configureAWD_USB();
+	}
+	else if (primary == powerSourceWide)
+	{
+		configureAWD_Wide();
+	}
+
+	updateFailoverPath();
+
+	HAL_ADCEx_Calibration_Start(&hadc);
+
+	if (startADC() != HAL_OK)
+	{
+		return;
+	}
+
+	latency_boot_timestamp = Latency_Now();
+	latency_boot_tick = HAL_GetTick();
+}
+
 void configureAWD_USB(void)
 {
 	ADC_AnalogWDGConfTypeDef AnalogWDGConfig;
@@ -863,11 +1179,12 @@ void configureAWD_USB(void)
 	AnalogWDGConfig.Channel = ADC_CHANNEL_7;
 	AnalogWDGConfig.ITMode = ENABLE;
 	AnalogWDGConfig.HighThreshold = 4095;
-	AnalogWDGConfig.LowThreshold = minUSB;
+	AnalogWDGConfig.LowThreshold = minUSB_fail;
 	if (HAL_ADC_AnalogWDGConfig(&hadc, &AnalogWDGConfig) != HAL_OK)
 	{
 		_Error_Handler(__FILE__, __LINE__);
 	}
+	awd_window = awdWindowFail;
 
 }
 
@@ -881,12 +1198,155 @@ void configureAWD_Wide(void)
 	AnalogWDGConfig.Channel = ADC_CHANNEL_5;
 	AnalogWDGConfig.ITMode = ENABLE;
 	AnalogWDGConfig.HighThreshold = 4095;
-	AnalogWDGConfig.LowThreshold = minWide;
+	AnalogWDGConfig.LowThreshold = minWide_fail;
+	if (HAL_ADC_AnalogWDGConfig(&hadc, &AnalogWDGConfig) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+	awd_window = awdWindowFail;
+
+}
+
+/*** configureADCMode
+ * Switches the ADC between the continuous and the timer-triggered acquisition mode (see adc_rate in main.h).
+ * The ADC has to be stopped, the analog watchdog configuration is kept by HAL_ADC_Init ***/
+
+void configureADCMode(void)
+{
+	TIM3->CR1 &= ~TIM_CR1_CEN;
+
+	if (adc_rate == 0)
+	{
+		hadc.Init.ContinuousConvMode = ENABLE;
+		hadc.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+		hadc.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+		hadc.Init.LowPowerAutoPowerOff = DISABLE;
+	}
+	else
+	{
+		hadc.Init.ContinuousConvMode = DISABLE;
+		hadc.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T3_TRGO;
+		hadc.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+		hadc.Init.LowPowerAutoPowerOff = adc_autooff == 1 ? ENABLE : DISABLE;
+	}
+
+	if (HAL_ADC_Init(&hadc) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+	if (adc_rate != 0)
+	{
+		TIM3->ARR = (adcTriggerClock / adc_rate) - 1;
+		TIM3->CNT = 0;
+		TIM3->CR1 |= TIM_CR1_CEN;
+	}
+}
+
+/*** Power-Back ADC-Watchdog
+ *
+ * After a failover the ADC-Watchdog of the primary source is re-armed with the inverted window
+ * (0 up to the restore threshold), so the return of the primary source raises the ADC-Watchdog
+ * interrupt as well. The interrupt starts the one-shot TIM16 for the minimum stable time, and when
+ * the primary source is still stable at its end, the main Task is woken up with mainEventPowerBack.
+ * The TIM16 period has a small margin, because the stable time is measured from the filtered ADC-Values,
+ * which are crossing the restore threshold a half-buffer after the single sample of the ADC-Watchdog.
+ *
+ * 	- configureAWD_PowerBack() programs the inverted window
+ * 	- armPowerBackWatchdog() stops the ADC for the reprogramming, because the thresholds
+ * 	  can only be written while the ADC isn't converting. It is called by the main Task (mainEventArmPowerBack),
+ * 	  because the HAL functions of the ADC take the lock of the handle, which may be held by the main Task
+ * 	  in the moment of the interrupt, and a failed call would leave the ADC-Watchdog disabled
+ *
+ * 																							  ***/
+
+void configureAWD_PowerBack(void)
+{
+	ADC_AnalogWDGConfTypeDef AnalogWDGConfig;
+
+	/**Configure the analog watchdog
+	 */
+	AnalogWDGConfig.WatchdogMode = ADC_ANALOGWATCHDOG_SINGLE_REG;
+	AnalogWDGConfig.ITMode = ENABLE;
+	AnalogWDGConfig.LowThreshold = 0;
+
+	if (modus == 1 || modus == 3)
+	{
+		AnalogWDGConfig.Channel = ADC_CHANNEL_7;
+		AnalogWDGConfig.HighThreshold = minUSB_restore;
+	}
+	else
+	{
+		AnalogWDGConfig.Channel = ADC_CHANNEL_5;
+		AnalogWDGConfig.HighThreshold = minWide_restore;
+	}
+
 	if (HAL_ADC_AnalogWDGConfig(&hadc, &AnalogWDGConfig) != HAL_OK)
 	{
 		_Error_Handler(__FILE__, __LINE__);
 	}
+	awd_window = awdWindowPowerBack;
+}
+
+void armPowerBackWatchdog(void)
+{
+	if (stopADC() != HAL_OK)
+	{
+		return;
+	}
+
+	configureAWD_PowerBack();
+
+	startADC();
+}
+
+static void startPowerBackDebounce(void)
+{
+	uint16_t stable_time = restore_stable_time;
+
+	/*** TIM16 counts milliseconds with a 16-bit auto-reload register ***/
+	if (stable_time > restore_stable_time_max)
+	{
+		stable_time = restore_stable_time_max;
+	}
+
+	TIM16->CR1 &= ~TIM_CR1_CEN;
+	TIM16->CNT = 0;
+	TIM16->ARR = stable_time + powerBackDebounceMargin;
+	TIM16->SR = ~TIM_SR_UIF;
+	TIM16->DIER |= TIM_DIER_UIE;
+	TIM16->CR1 |= TIM_CR1_CEN;
+}
+
+void powerBackDebounceElapsed(void)
+{
+	uint8_t stable;
+
+	if (awd_window != awdWindowPowerBack)
+	{
+		return;
+	}
+
+	if (modus == 1 || modus == 3)
+	{
+		stable = restoreStable_USB();
+	}
+	else
+	{
+		stable = restoreStable_Wide();
+	}
 
+	if (stable)
+	{
+		powerback_irq_counter++;
+		notifyMainTask(mainEventPowerBack);
+	}
+	else
+	{
+		/*** The primary source has dropped again during the stable time, so the next return is awaited ***/
+		__HAL_ADC_CLEAR_FLAG(&hadc, ADC_FLAG_AWD);
+		__HAL_ADC_ENABLE_IT(&hadc, ADC_IT_AWD);
+	}
 }
 
 /*********************************************************************************/
@@ -903,6 +1363,17 @@ void configureAWD_Wide(void)
 
 void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef* hadc)
 {
+	uint8_t backup;
+
+	/*** With the inverted window the ADC-Watchdog has detected the return of the primary source,
+	 * which is confirmed after the minimum stable time by TIM16 ***/
+	if (awd_window == awdWindowPowerBack)
+	{
+		__HAL_ADC_DISABLE_IT(hadc, ADC_IT_AWD);
+		startPowerBackDebounce();
+		return;
+	}
+
 	__disable_irq();
 
 	/*** Here the StromPi3 switches the PowerPath depended which mode is configured
@@ -917,31 +1388,28 @@ void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef* hadc)
 	 *
 	 *   ***/
 
-	if (modus == 1)
-	{
-		Power_Wide();
-		if (warning_enable == 1)
-		{
-			warning_flag = 1;
-		}
-	}
-	else if (modus == 2)
+	backup = PowerArbiter_Backup(modus);
+	if (backup != powerSourceNone)
 	{
-		Power_USB();
+		Power_Source(backup);
 		if (warning_enable == 1)
 		{
 			warning_flag = 1;
 		}
 	}
-	else if (modus == 3 || modus == 4)
+
+	/*** Failover latency measurement: ADC-Watchdog interrupt entry -> PowerPath switched
+	 * With the fast failover the PowerPath has already been switched in the interrupt vector,
+	 * so the Power_*() calls above only update the state variables ***/
+	if (failover_bsrr == 0)
 	{
-		Power_Bat();
-		powerBat_flag = 1;
-		if (warning_enable == 1)
-		{
-			warning_flag = 1;
-		}
+		latency_switch_timestamp = Latency_Now();
 	}
+	Latency_Record(&latency_switch, latency_switch_timestamp - latency_awd_timestamp);
+	latency_task_pending = 1;
+
+	/*** Freezes the waveform capture after its post-trigger values ***/
+	Capture_Trigger();
 
 	if (manual_poweroff_flag == 1)
 	{
@@ -973,29 +1441,425 @@ void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef* hadc)
 		powerfailure_counter_block = 1;
 	}
 
+	/*** Counts, if the failover has been triggered by the predictive brown-out detection or by the ADC-Watchdog threshold ***/
+	if (slope_failover_flag == 1)
+	{
+		slope_failover_counter++;
+		slope_failover_flag = 0;
+	}
+	else
+	{
+		threshold_failover_counter++;
+	}
+
 	/*** This line deactivates the ADC Watchdog
 	 * Its main purpose is to make sure to register a powerfailure probably once
 	 * and that the ADC Watchdog Callback wouldn't be retriggered before the powerfailure
 	 * processing in the main task have finished ***/
 	__HAL_ADC_DISABLE_IT(hadc, ADC_IT_AWD);
 	__enable_irq();
+
+	/*** The minimum stable time of the primary source starts again after every failover,
+	 * and the main Task re-arms the ADC-Watchdog to detect the return of the primary source.
+	 * In the three-stage-mode the main Task reconfigures the ADC-Watchdog to monitor the secondary source instead ***/
+	resetRestoreState();
+
+	/*** The shutdown or warning message is sent by the main Task right away, not at its next second ***/
+	if (threeStageMode == 0)
+	{
+		notifyMainTask(mainEventPowerFail | mainEventArmPowerBack);
+	}
+	else
+	{
+		notifyMainTask(mainEventPowerFail);
+	}
 }
 
 /*********************************************************************************/
 
-/*** ADC Watchdog Interrupt
- *
- * flashConfig() is used for storing all of the configuration values to the flash
- * of the STM32F031 MCU, so it can be retrieved after a shutdown.
+/*** ADC DMA Interrupts
  *
- * flashValue() is a help function which is using the STM32-HAL for this matter.
+ * The DMA is running in circular mode over both halves of adcDMABuffer.
+ * At the half-transfer the first half is complete, at the transfer-complete the second half,
+ * so the finished half can be averaged while the DMA is writing into the other one.
+ * The averaged values are stored into rawValue, so the failover and restore decisions
+ * are made on filtered values instead of a single noisy sample.
  *
- * 																			  ***/
+ * 																							  ***/
 
-void flashConfig(void)
+/*** Failover hysteresis
+ * The filtered values of the primary sources are compared with their restore thresholds
+ * on every half-buffer, so a short drop under the restore threshold between two runs
+ * of the main Task restarts the minimum stable time as well ***/
+
+static volatile uint8_t restoreAbove_Wide;
+static volatile uint8_t restoreAbove_USB;
+static volatile uint32_t restoreSince_Wide;
+static volatile uint32_t restoreSince_USB;
+
+static void updateRestoreState(void)
+{
+	if (rawValue[0] > minWide_restore)
+	{
+		if (restoreAbove_Wide == 0)
+		{
+			restoreSince_Wide = HAL_GetTick();
+			restoreAbove_Wide = 1;
+		}
+	}
+	else
+	{
+		restoreAbove_Wide = 0;
+	}
+
+	if (rawValue[2] > minUSB_restore)
+	{
+		if (restoreAbove_USB == 0)
+		{
+			restoreSince_USB = HAL_GetTick();
+			restoreAbove_USB = 1;
+		}
+	}
+	else
+	{
+		restoreAbove_USB = 0;
+	}
+}
+
+static void resetRestoreState(void)
+{
+	restoreAbove_Wide = 0;
+	restoreAbove_USB = 0;
+}
+
+uint8_t restoreStable_Wide(void)
+{
+	return restoreAbove_Wide == 1 && (HAL_GetTick() - restoreSince_Wide) >= restore_stable_time;
+}
+
+uint8_t restoreStable_USB(void)
+{
+	return restoreAbove_USB == 1 && (HAL_GetTick() - restoreSince_USB) >= restore_stable_time;
+}
+
+/*** Predictive brown-out detection
+ *
+ * The filtered value of the primary source and the TIM2 timestamp of every half-buffer are kept
+ * in a small history, the drop over the history is compared against slope_rate without a division:
+ *
+ *   drop [ADC-Value] * 1000 >= slope_rate [ADC-Value/ms] * time [us]
+ *
+ * The products don't fit into 32 bits at a low adc_rate (see slope.h).
+ *
+ * The estimator only runs while the ADC-Watchdog is armed, so it can't trigger again
+ * before the main Task has restored the primary source.
+ *
+ * 	- slope_mode 1 pre-arms the backup source: in the power save mode the L7987 of the Wide-Range
+ * 	  input is turned on, so the StepDownConverter is already running when the ADC-Watchdog switches.
+ * 	  It is turned off again by Power_USB() of the main Task when the primary source is stable.
+ * 	- slope_mode 2 switches the PowerPath right away, in the same way as the ADC-Watchdog ***/
+
+static uint16_t slopeValue[slopeWindow];
+static uint32_t slopeTime[slopeWindow];
+static uint8_t slopeIndex;
+static uint8_t slopeCount;
+static uint8_t slopeChannel;
+static uint8_t slopeTriggered;
+
+static void updateSlopeEstimator(void)
+{
+	uint8_t channel;
+	uint8_t oldest;
+	uint16_t drop;
+	uint32_t time;
+	uint32_t max_time;
+	uint32_t now = Latency_Now();
+
+	if (modus == 1 || modus == 3)
+	{
+		channel = 2;
+	}
+	else if (modus == 2 || modus == 4)
+	{
+		channel = 0;
+	}
+	else
+	{
+		return;
+	}
+
+	if (slope_mode == 0 || awd_window != awdWindowFail || !__HAL_ADC_GET_IT_SOURCE(&hadc, ADC_IT_AWD) || channel != slopeChannel)
+	{
+		slopeChannel = channel;
+		slopeCount = 0;
+		slopeTriggered = 0;
+		return;
+	}
+
+	slopeValue[slopeIndex] = rawValue[channel];
+	slopeTime[slopeIndex] = now;
+	slopeIndex = (slopeIndex + 1) % slopeWindow;
+
+	if (slopeCount < slopeWindow)
+	{
+		slopeCount++;
+		return;
+	}
+
+	/*** slopeIndex now points to the oldest value of the history ***/
+	oldest = slopeIndex;
+
+	if (slopeValue[oldest] <= rawValue[channel])
+	{
+		slopeTriggered = 0;
+		return;
+	}
+
+	drop = slopeValue[oldest] - rawValue[channel];
+	time = now - slopeTime[oldest];
+
+	/*** A gap in the ADC-Stream (e.g. reconfigureWatchdog()) isn't a slope, so the history is restarted.
+	 * The history covers slopeWindow half-buffers of adcOversampling scans each, so at a low adc_rate it takes
+	 * longer than a second (e.g. 32 seconds at 1 scan per second) ***/
+	max_time = slopeMaxTimeContinuous;
+	if (adc_rate != 0)
+	{
+		max_time = 2UL * slopeWindow * adcOversampling * 1000000UL / adc_rate;
+	}
+
+	if (time > max_time)
+	{
+		slopeCount = 0;
+		return;
+	}
+
+	if (Slope_Steeper(drop, time, slope_peak_drop, slope_peak_time))
+	{
+		slope_peak_drop = drop;
+		slope_peak_time = time;
+	}
+
+	if (!Slope_Exceeds(drop, time, slope_rate))
+	{
+		slopeTriggered = 0;
+		return;
+	}
+
+	if (slopeTriggered == 1)
+	{
+		return;
+	}
+	slopeTriggered = 1;
+
+	if (slope_mode == 1)
+	{
+		slope_prearm_counter++;
+		if (modus == 1 && powersave_enable == 1)
+		{
+			HAL_GPIO_WritePin(CTRL_L7987_GPIO_Port, CTRL_L7987_Pin, GPIO_PIN_SET);
+		}
+	}
+	else if (slope_mode == 2)
+	{
+		latency_awd_timestamp = now;
+		if (failover_bsrr != 0)
+		{
+			GPIOA->BSRR = failover_bsrr;
+			latency_switch_timestamp = Latency_Now();
+		}
+		slope_failover_flag = 1;
+		HAL_ADC_LevelOutOfWindowCallback(&hadc);
+	}
+}
+
+void resetSlopeCounters(void)
+{
+	slope_prearm_counter = 0;
+	slope_failover_counter = 0;
+	threshold_failover_counter = 0;
+	slope_peak_drop = 0;
+	slope_peak_time = 0;
+}
+
+static void filterADCSamples(const uint16_t *samples)
+{
+	uint32_t sum[adcChannels] = { 0 };
+	uint8_t scan;
+	uint8_t channel;
+
+	for (scan = 0; scan < adcOversampling; scan++)
+	{
+		for (channel = 0; channel < adcChannels; channel++)
+		{
+			sum[channel] += *samples++;
+		}
+	}
+
+	for (channel = 0; channel < adcChannels; channel++)
+	{
+		rawValue[channel] = sum[channel] / adcOversampling;
+	}
+
+	updateRestoreState();
+	updateSlopeEstimator();
+	ADCStats_Update(rawValue);
+	Capture_Sample(rawValue);
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc)
+{
+	filterADCSamples(&adcDMABuffer[0]);
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+{
+	filterADCSamples(&adcDMABuffer[adcDMABufferSize / 2]);
+}
+
+/*********************************************************************************/
+
+/*** ADC Conversion
+ *
+ * The measured Voltages are calculated with
+ *
+ *   VDD = 3300mV * VREFINT_CAL / VREFINT
+ *   Voltage = VDD * ADC-Value / 4095 * (R1 + R2) / R2
+ *
+ * The Cortex-M0 has no hardware divider, so the divisions are only done once per change
+ * of the filtered VREFINT value: the scale factor of each channel (mV per LSB with adcScaleShift
+ * fractional bits) is VDD multiplied with the constant divider ratio of the channel.
+ * The divider ratios are precomputed by the compiler with adcRatioShift additional fractional bits,
+ * so all products stay inside of 32 bits (VDD < 3.6V, ADC-Value < 4096).
+ *
+ * 																							  ***/
+
+#define ADC_RATIO(r_sum, r_low) ((uint32_t) (((uint64_t) (r_sum) << (adcScaleShift + adcRatioShift)) / ((uint64_t) (r_low) * 4095)))
+
+static const uint32_t adcRatio[4] =
+{ ADC_RATIO(105100, 5100), ADC_RATIO(15100, 5100), ADC_RATIO(15100, 5100), ADC_RATIO(15100, 5100) };
+
+static uint32_t adcScale[4];
+static uint16_t adcScaleVREF;
+
+static void updateADCScale(uint16_t vref)
+{
+	uint32_t VDDValue;
+	uint8_t channel;
+
+	VDDValue = 3300 * VREFINT_CAL / vref;
+
+	for (channel = 0; channel < 4; channel++)
+	{
+		adcScale[channel] = (VDDValue * adcRatio[channel]) >> adcRatioShift;
+	}
+
+	measuredValue[4] = VDDValue;
+	adcScaleVREF = vref;
+}
+
+void updateMeasuredValues(void)
+{
+	uint8_t channel;
+
+	if (rawValue[4] != adcScaleVREF && rawValue[4] != 0)
+	{
+		updateADCScale(rawValue[4]);
+	}
+
+	for (channel = 0; channel < 4; channel++)
+	{
+		measuredValue[channel] = (rawValue[channel] * adcScale[channel]) >> adcScaleShift;
+	}
+}
+
+/*** convertADCValue
+ * Converts a raw ADC-Value of the channel into millivolts with the actual scale factors,
+ * for channel 4 (VREFINT) the corresponding VDD is returned ***/
+
+uint16_t convertADCValue(uint8_t channel, uint16_t raw)
+{
+	if (channel < 4)
+	{
+		return (raw * adcScale[channel]) >> adcScaleShift;
+	}
+
+	return raw != 0 ? 3300 * VREFINT_CAL / raw : 0;
+}
+
+/*** Cycle count comparison of the conversion (for the adc-benchmark command)
+ * The Cortex-M0 has no cycle counter, so the cycles are measured with the SysTick,
+ * which is counting down with the core clock.
+ *
+ * 		- cycles[0]: previous conversion with the divisions in every call
+ * 		- cycles[1]: conversion with recalculation of the scale factors
+ * 		- cycles[2]: conversion with cached scale factors
+ ***/
+
+static uint32_t cyclesSince(uint32_t start)
+{
+	uint32_t now = SysTick->VAL;
+
+	if (start >= now)
+	{
+		return start - now;
+	}
+	return start + (SysTick->LOAD + 1) - now;
+}
+
+void benchmarkADCConversion(uint32_t *cycles)
+{
+	volatile uint16_t legacyValue[4];
+	uint16_t VDDValue;
+	uint32_t start;
+
+	if (rawValue[4] == 0)
+	{
+		cycles[0] = cycles[1] = cycles[2] = 0;
+		return;
+	}
+
+	taskENTER_CRITICAL();
+
+	start = SysTick->VAL;
+	VDDValue = 3300 * VREFINT_CAL / rawValue[4];
+	legacyValue[0] = VDDValue * rawValue[0] / 4095 * 105100 / 5100;
+	legacyValue[1] = VDDValue * rawValue[1] / 4095 * 15100 / 5100;
+	legacyValue[2] = VDDValue * rawValue[2] / 4095 * 15100 / 5100;
+	legacyValue[3] = VDDValue * rawValue[3] / 4095 * 15100 / 5100;
+	cycles[0] = cyclesSince(start);
+
+	start = SysTick->VAL;
+	adcScaleVREF = 0;
+	updateMeasuredValues();
+	cycles[1] = cyclesSince(start);
+
+	start = SysTick->VAL;
+	updateMeasuredValues();
+	cycles[2] = cyclesSince(start);
+
+	taskEXIT_CRITICAL();
+
+	(void) legacyValue;
+}
+
+/*********************************************************************************/
+
+/*** ADC Watchdog Interrupt
+ *
+ * flashConfig() is used for storing all of the configuration values to the flash
+ * of the STM32F031 MCU, so it can be retrieved after a shutdown.
+ *
+ * flashValue() is a help function which is using the STM32-HAL for this matter.
+ *
+ * 																			  ***/
+
+void flashConfig(void)
 {
 	FLASH_EraseInitTypeDef EraseInitStruct;
 
+	/*** The schedule table shares the flash page, so it is copied before the erase ***/
+	Schedule_Copy();
+
 	HAL_FLASH_Unlock();
 	EraseInitStruct.TypeErase = FLASH_TYPEERASE_PAGES;
 	EraseInitStruct.PageAddress = 0x8007C00;
@@ -1044,6 +1908,18 @@ void flashConfig(void)
 	flashValue(wakeup_time_enable_FlashAdress, wakeup_time_enable);
 	flashValue(wakeup_time_FlashAdress, wakeup_time);
 	flashValue(wakeupweekend_enable_FlashAdress, wakeupweekend_enable);
+	flashValue(minUSB_fail_FlashAdress, minUSB_fail);
+	flashValue(minUSB_restore_FlashAdress, minUSB_restore);
+	flashValue(minWide_fail_FlashAdress, minWide_fail);
+	flashValue(minWide_restore_FlashAdress, minWide_restore);
+	flashValue(restore_stable_time_FlashAdress, restore_stable_time);
+	flashValue(slope_mode_FlashAdress, slope_mode);
+	flashValue(slope_rate_FlashAdress, slope_rate);
+	flashValue(adc_rate_FlashAdress, adc_rate);
+	flashValue(adc_autooff_FlashAdress, adc_autooff);
+	flashValue(loop_period_FlashAdress, loop_period);
+
+	Schedule_Flash();
 
 	HAL_FLASH_Lock();
 
@@ -1051,6 +1927,11 @@ void flashConfig(void)
 
 void updateConfig(void)
 {
+	uint16_t previous_minUSB_fail = minUSB_fail;
+	uint16_t previous_minWide_fail = minWide_fail;
+	uint16_t previous_adc_rate = adc_rate;
+	uint8_t previous_adc_autooff = adc_autooff;
+
 	modus = configParamters[1];
 	alarmDate = configParamters[2];
 	alarmWeekDay = configParamters[3];
@@ -1079,12 +1960,246 @@ void updateConfig(void)
 	wakeup_time_enable = configParamters[26];
 	wakeup_time = configParamters[27];
 	wakeupweekend_enable = configParamters[28];
+	minUSB_fail = configParamters[29];
+	minUSB_restore = configParamters[30];
+	minWide_fail = configParamters[31];
+	minWide_restore = configParamters[32];
+	restore_stable_time = configParamters[33];
+	slope_mode = configParamters[34];
+	slope_rate = configParamters[35];
+	adc_rate = configParamters[36];
+	adc_autooff = configParamters[37];
+	loop_period = configParamters[38];
 	wakeup_time_counter = wakeup_time;
 
+	validateConfig();
+
+	/*** The ADC and its Watchdog have to be reprogrammed with a changed fail threshold or acquisition mode.
+	 * This is done by the main Task, which owns the ADC, because the configuration is changed by the console task ***/
+	if (minUSB_fail != previous_minUSB_fail || minWide_fail != previous_minWide_fail || adc_rate != previous_adc_rate || adc_autooff != previous_adc_autooff)
+	{
+		notifyMainTask(mainEventReconfigure);
+	}
+
+	updateFailoverPath();
 
 	flashConfig();
 }
 
+/*** setConfig
+ * Sets the configuration parameter index to value, like the command "set-config index value" of the serial console
+ * (index 0 applies the changed parameters: value 0 updates the configuration, value 1 additionally reprograms the
+ * ADC-Watchdog, value 2 ends the communication in the serial-less mode) ***/
+
+void setConfig(uint8_t index, uint32_t value)
+{
+	if (index == 0 && value == 0)
+	{
+		updateConfig();
+	}
+	else if (index == 0 && value == 1)
+	{
+		updateConfig();
+		notifyMainTask(mainEventReconfigure);
+	}
+	else if (index == 0 && value == 2)
+	{
+		if (serialLessMode == 1)
+		{
+			serialLess_communication_off_counter = 5;
+		}
+	}
+	else if (index == 1)
+	{
+		configParamters[index] = value;
+		if (value < 5)
+		{
+			threeStageMode = 0;
+		}
+		else if (value == 5)
+		{
+			threeStageMode = 1;
+			modus = 1;
+		}
+		else if (value == 6)
+		{
+			threeStageMode = 2;
+			modus = 2;
+		}
+
+	}
+	else if (index == 24)
+	{
+		configParamters[index] = value;
+		if (value == 1)
+		{
+			if (output_status == 0x2)
+			{
+				HAL_GPIO_WritePin(CTRL_L7987_GPIO_Port, CTRL_L7987_Pin, GPIO_PIN_SET);
+			}
+			else
+			{
+				HAL_GPIO_WritePin(CTRL_L7987_GPIO_Port, CTRL_L7987_Pin, GPIO_PIN_RESET);
+			}
+		}
+	}
+	else if (index > 1 && index < configMax)
+	{
+		configParamters[index] = value;
+	}
+}
+
+/*** Smallest and largest value of the configuration parameters 1 to configMax-1 for setConfigAll()
+ * (the variables have at most 16 bits) ***/
+
+static const uint16_t configLimit[configMax][2] =
+{
+	{ 0, 0 }, /*** 0 isn't a parameter ***/
+	{ 1, 6 }, /*** modus (5 and 6 are the three-stage modes) ***/
+	{ 0, 1 }, /*** alarmDate ***/
+	{ 0, 1 }, /*** alarmWeekDay ***/
+	{ 0, 1 }, /*** alarmTime ***/
+	{ 0, 1 }, /*** alarmPoweroff ***/
+	{ 0, 59 }, /*** alarm_min ***/
+	{ 0, 23 }, /*** alarm_hour ***/
+	{ 0, 59 }, /*** alarm_min_off ***/
+	{ 0, 23 }, /*** alarm_hour_off ***/
+	{ 1, 31 }, /*** alarm_day ***/
+	{ 1, 12 }, /*** alarm_month ***/
+	{ 1, 7 }, /*** alarm_weekday ***/
+	{ 0, 1 }, /*** alarm_enable ***/
+	{ 0, 1 }, /*** shutdown_enable ***/
+	{ 0, 0xFFFF }, /*** shutdown_time ***/
+	{ 0, 1 }, /*** warning_enable ***/
+	{ 0, 1 }, /*** serialLessMode ***/
+	{ 0, 0xFF }, /*** batLevel_shutdown ***/
+	{ 0, 1 }, /*** alarmInterval ***/
+	{ 0, 0xFFFF }, /*** alarmIntervalMinOn ***/
+	{ 0, 0xFFFF }, /*** alarmIntervalMinOff ***/
+	{ 0, 1 }, /*** powerOnButton_enable ***/
+	{ 0, 0xFFFF }, /*** powerOnButton_time ***/
+	{ 0, 1 }, /*** powersave_enable ***/
+	{ 0, 1 }, /*** poweroff_enable ***/
+	{ 0, 1 }, /*** wakeup_time_enable ***/
+	{ 0, 0xFFFF }, /*** wakeup_time ***/
+	{ 0, 1 }, /*** wakeupweekend_enable ***/
+	{ 0, 4095 }, /*** minUSB_fail ***/
+	{ 0, 4095 }, /*** minUSB_restore ***/
+	{ 0, 4095 }, /*** minWide_fail ***/
+	{ 0, 4095 }, /*** minWide_restore ***/
+	{ 0, restore_stable_time_max }, /*** restore_stable_time ***/
+	{ 0, 2 }, /*** slope_mode ***/
+	{ 1, 4095 }, /*** slope_rate ***/
+	{ 0, adc_rate_max }, /*** adc_rate ***/
+	{ 0, 1 }, /*** adc_autooff ***/
+	{ loop_period_min, 1000 }, /*** loop_period ***/
+};
+
+/*** setConfigAll
+ * Sets all configuration parameters from 1 to configMax-1 at once, the values have two bytes each (little endian,
+ * like they are received by the binary protocol, see protocol.h) and value[0] is parameter 1.
+ * All values are checked first, so either none or all parameters are changed. They are applied together
+ * by a single updateConfig(), which writes the flash page once.
+ * Returns 0 on success, otherwise the first parameter out of range ***/
+
+uint8_t setConfigAll(const uint8_t *value)
+{
+	uint8_t index;
+	uint16_t parameter;
+
+	for (index = 1; index < configMax; index++)
+	{
+		parameter = value[2 * index - 2] | (value[2 * index - 1] << 8);
+		if (parameter < configLimit[index][0] || parameter > configLimit[index][1])
+		{
+			return index;
+		}
+
+		/*** validateConfig() would replace a loop_period, which isn't a divisor of 1000, with the default ***/
+		if (index == 38 && 1000 % parameter != 0)
+		{
+			return index;
+		}
+	}
+
+	for (index = 1; index < configMax; index++)
+	{
+		setConfig(index, value[2 * index - 2] | (value[2 * index - 1] << 8));
+	}
+
+	updateConfig();
+
+	return 0;
+}
+
+/*** validateConfig
+ * Replaces blank or invalid values of the parameters from 29 on with the defaults and makes sure, that every
+ * restore threshold isn't below its fail threshold, so the hysteresis can't be negative ***/
+
+void validateConfig(void)
+{
+	if (minUSB_fail > 4095)
+	{
+		minUSB_fail = minUSB;
+	}
+	if (minUSB_restore > 4095)
+	{
+		minUSB_restore = minUSB_restore_default;
+	}
+	if (minWide_fail > 4095)
+	{
+		minWide_fail = minWide;
+	}
+	if (minWide_restore > 4095)
+	{
+		minWide_restore = minWide_restore_default;
+	}
+	if (restore_stable_time > restore_stable_time_max)
+	{
+		restore_stable_time = restore_stable_time_default;
+	}
+	if (slope_mode > 2)
+	{
+		slope_mode = slope_mode_default;
+	}
+	if (slope_rate == 0 || slope_rate > 4095)
+	{
+		slope_rate = slope_rate_default;
+	}
+	if (adc_rate > adc_rate_max)
+	{
+		adc_rate = 0;
+	}
+	if (adc_autooff > 1)
+	{
+		adc_autooff = 0;
+	}
+	if (loop_period < loop_period_min || loop_period > 1000 || 1000 % loop_period != 0)
+	{
+		loop_period = loop_period_default;
+	}
+
+	if (minUSB_restore < minUSB_fail)
+	{
+		minUSB_restore = minUSB_fail;
+	}
+	if (minWide_restore < minWide_fail)
+	{
+		minWide_restore = minWide_fail;
+	}
+
+	configParamters[29] = minUSB_fail;
+	configParamters[30] = minUSB_restore;
+	configParamters[31] = minWide_fail;
+	configParamters[32] = minWide_restore;
+	configParamters[33] = restore_stable_time;
+	configParamters[34] = slope_mode;
+	configParamters[35] = slope_rate;
+	configParamters[36] = adc_rate;
+	configParamters[37] = adc_autooff;
+	configParamters[38] = loop_period;
+}
+
 void flashValue(uint32_t address, uint32_t data)
 {
 	if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, data) != HAL_OK)
@@ -1103,14 +2218,42 @@ void flashValue(uint32_t address, uint32_t data)
 	}
 }
 
-/*********************************************************************************/
+/*********************************************************************************/
+
+/*********************************************************************************/
+
+/*** Alarm_PowerOn
+ * Turns the Raspberry Pi PowerPath on by a wake alarm, by the schedule table or by the power-on button,
+ * from the primary source, if it is available, otherwise from the backup source of the modus (see power_arbiter.h) ***/
+
+void Alarm_PowerOn(void)
+{
+	uint8_t source = PowerArbiter_Select(modus, availableSources());
+
+	if (source != powerSourceNone)
+	{
+		poweroff_flag = 0;
+		Power_Source(source);
+	}
+}
+
+/*** Alarm_PowerOff
+ * Shuts the Raspberry Pi down by the poweroff alarm or by the schedule table,
+ * the PowerPath is cut off after the shutdown time ***/
 
-/*********************************************************************************/
+void Alarm_PowerOff(void)
+{
+	poweroff_flag = 1;
+	ShutdownRPi();
+	Config_Reset_Pin_Input_PullDOWN();
+	alarm_shutdown_time_counter = shutdown_time;
+	alarmPoweroff_flag = 1;
+}
 
 /*** Alarm_Handler
  *
  * This function is the main part of the time based sheduling system of the StromPi3
- * It is called every minute in the main Task and is checking if one
+ * It is called every minute in the main Task (woken up by the RTC Alarm A at the full minute) and is checking if one
  * of the preprogrammed events is triggered - in this case the StromPi3 restarts the
  * RPi through switch the poweroff_flag to 0.
  * As for this the StromPi3 have to be in hi "shutdown-state" (poweroff_flag=1), which can be
@@ -1134,18 +2277,16 @@ void Alarm_Handler(void)
 	HAL_RTC_GetTime(&hrtc, &stimestructureget, RTC_FORMAT_BIN);
 	HAL_RTC_GetDate(&hrtc, &sdatestructureget, RTC_FORMAT_BIN);
 
+	/*** The entries of the schedule table (see schedule.h) ***/
+	Schedule_Handler(&stimestructureget, &sdatestructureget);
+
 	/*** This part handles the preprogrammed shutdown function  ***/
 
 	if (alarmPoweroff == 1)
 	{
 		if (alarm_min_off == stimestructureget.Minutes && alarm_hour_off == stimestructureget.Hours)
 		{
-			poweroff_flag = 1;
-			ShutdownRPi();
-			Config_Reset_Pin_Input_PullDOWN();
-			alarm_shutdown_time_counter = shutdown_time;
-			alarmPoweroff_flag = 1;
-
+			Alarm_PowerOff();
 		}
 	}
 
@@ -1166,135 +2307,21 @@ void Alarm_Handler(void)
 		{
 			if (alarm_min == stimestructureget.Minutes && alarm_hour == stimestructureget.Hours)
 			{
-				if (modus == 1 || modus == 3)
-				{
-					if (rawValue[2] > minUSB)
-					{
-						poweroff_flag = 0;
-						Power_USB();
-					}
-					else if (modus == 1)
-					{
-						poweroff_flag = 0;
-						Power_Wide();
-					}
-					else if (modus == 3)
-					{
-						poweroff_flag = 0;
-						Power_Bat();
-						powerBat_flag = 1;
-					}
-				}
-
-				else if (modus == 2 || modus == 4)
-				{
-					if (rawValue[0] > minWide)
-					{
-						poweroff_flag = 0;
-						Power_Wide();
-					}
-					else if (modus == 2)
-					{
-						poweroff_flag = 0;
-						Power_USB();
-					}
-					else if (modus == 4)
-					{
-						poweroff_flag = 0;
-						Power_Bat();
-						powerBat_flag = 1;
-					}
-				}
+				Alarm_PowerOn();
 			}
 		}
 		if (alarmTime == 1 && wakeupweekend_enable == 1)
 				{
 					if (alarm_min == stimestructureget.Minutes && alarm_hour == stimestructureget.Hours)
 					{
-						if (modus == 1 || modus == 3)
-						{
-							if (rawValue[2] > minUSB)
-							{
-								poweroff_flag = 0;
-								Power_USB();
-							}
-							else if (modus == 1)
-							{
-								poweroff_flag = 0;
-								Power_Wide();
-							}
-							else if (modus == 3)
-							{
-								poweroff_flag = 0;
-								Power_Bat();
-								powerBat_flag = 1;
-							}
-						}
-
-						else if (modus == 2 || modus == 4)
-						{
-							if (rawValue[0] > minWide)
-							{
-								poweroff_flag = 0;
-								Power_Wide();
-							}
-							else if (modus == 2)
-							{
-								poweroff_flag = 0;
-								Power_USB();
-							}
-							else if (modus == 4)
-							{
-								poweroff_flag = 0;
-								Power_Bat();
-								powerBat_flag = 1;
-							}
-						}
+						Alarm_PowerOn();
 					}
 				}
 		else if (alarmWeekDay == 1)
 		{
 			if (alarm_min == stimestructureget.Minutes && alarm_hour == stimestructureget.Hours && alarm_weekday == sdatestructureget.WeekDay)
 			{
-				if (modus == 1 || modus == 3)
-				{
-					if (rawValue[2] > minUSB)
-					{
-						poweroff_flag = 0;
-						Power_USB();
-					}
-					else if (modus == 1)
-					{
-						poweroff_flag = 0;
-						Power_Wide();
-					}
-					else if (modus == 3)
-					{
-						poweroff_flag = 0;
-						Power_Bat();
-						powerBat_flag = 1;
-					}
-				}
-
-				else if (modus == 2 || modus == 4)
-				{
-					if (rawValue[0] > minWide)
-					{
-						poweroff_flag = 0;
-						Power_Wide();
-					}
-					else if (modus == 2)
-					{
-						poweroff_flag = 0;
-						Power_USB();
-					}
-					else if (modus == 4)
-					{
-						poweroff_flag = 0;
-						Power_Bat();
-						powerBat_flag = 1;
-					}
-				}
+				Alarm_PowerOn();
 			}
 		}
 
@@ -1302,45 +2329,7 @@ void Alarm_Handler(void)
 		{
 			if (alarm_min == stimestructureget.Minutes && alarm_hour == stimestructureget.Hours && alarm_day == sdatestructureget.Date && alarm_month == sdatestructureget.Month)
 			{
-				if (modus == 1 || modus == 3)
-				{
-					if (rawValue[2] > minUSB)
-					{
-						poweroff_flag = 0;
-						Power_USB();
-					}
-					else if (modus == 1)
-					{
-						poweroff_flag = 0;
-						Power_Wide();
-					}
-					else if (modus == 3)
-					{
-						poweroff_flag = 0;
-						Power_Bat();
-						powerBat_flag = 1;
-					}
-				}
-
-				else if (modus == 2 || modus == 4)
-				{
-					if (rawValue[0] > minWide)
-					{
-						poweroff_flag = 0;
-						Power_Wide();
-					}
-					else if (modus == 2)
-					{
-						poweroff_flag = 0;
-						Power_USB();
-					}
-					else if (modus == 4)
-					{
-						poweroff_flag = 0;
-						Power_Bat();
-						powerBat_flag = 1;
-					}
-				}
+				Alarm_PowerOn();
 			}
 		}
 	}
@@ -1429,6 +2418,177 @@ void initialCheck(void)
 	}
 }
 
+/*** rearmFailWatchdog
+ * Turns the ADC-Watchdog-Interrupt back on for the next powerfailure.
+ * If the ADC-Watchdog is still armed with the inverted power-back window, it is reconfigured first ***/
+
+static void rearmFailWatchdog(void)
+{
+	if (awd_window == awdWindowPowerBack)
+	{
+		TIM16->DIER &= ~TIM_DIER_UIE;
+		TIM16->CR1 &= ~TIM_CR1_CEN;
+		reconfigureWatchdog();
+	}
+	else
+	{
+		__HAL_ADC_CLEAR_FLAG(&hadc, ADC_FLAG_AWD);
+		__HAL_ADC_ENABLE_IT(&hadc, ADC_IT_AWD);
+	}
+}
+
+/*** restorePrimary
+ * Turns the Raspberry Pi PowerPath backs on if the primary Voltage source has came back to life
+ * Also the ADC-Watchdog-Interrupt is turned back on, so it can trigger once again.
+ * The transition of the primary voltage source to the backup source, is monitored and will be
+ * switched in the most critical manner (as soon as possible: directly in the ADC-Watchdog Interrupt),
+ * but the transition from the backup source to the primary voltage is triggered here in the main Task
+ * in its "1-second" period of time or right after the debounced power-back interrupt, as soon as the primary source has been above its restore threshold
+ * for the configured minimum stable time. ***/
+
+static void restorePrimary(void)
+{
+	uint8_t primary = PowerArbiter_Primary(modus);
+
+	if (primary == powerSourceNone || !(availableSources() & powerAvailable(primary)) || poweroff_flag == 1)
+	{
+		return;
+	}
+
+	Power_Source(primary);
+	rearmFailWatchdog();
+
+	if (serialLessMode)
+	{
+		HAL_GPIO_WritePin(RESET_Rasp_GPIO_Port, RESET_Rasp_Pin, GPIO_PIN_SET);
+		serialLess_communication_on_flag = 0;
+	}
+
+	shutdown_time_counter = 0;
+
+	powerBat_flag = 0;
+
+	/*** In the three-stage-mode only the return of its first stage (the primary source of the mode 1 or 2
+	 * with the same number) is reported ***/
+	if (powerback_flag == 1 && (threeStageMode == 0 || PowerArbiter_Primary(threeStageMode) == primary))
+	{
+		PowerBack();
+		powerback_flag = 0;
+	}
+}
+
+/*** processShutdownFlags
+ * Processing of the shutdown_flag
+ * The Counter for the shutdown-timer is set
+ * and the warning message for the Raspberry Pi Shutdown
+ * is sent out through the serial interface
+ *
+ * Processing of the warning_flag
+ * If the shutdown-timer is deactivated, but the
+ * warning feature is enabled, then here the powerfail-warning
+ * is generated ***/
+
+static void processShutdownFlags(void)
+{
+	if (((shutdown_enable == 1 && shutdown_flag == 1) || (warning_enable == 1 && warning_flag == 1)) && latency_task_pending == 1)
+	{
+		/*** Failover latency measurement: ADC-Watchdog interrupt entry -> main Task processing ***/
+		Latency_Record(&latency_task, Latency_Now() - latency_awd_timestamp);
+		latency_task_pending = 0;
+	}
+
+	if ((shutdown_enable == 1 && shutdown_flag == 1) || alarm_shutdown_enable == 1)
+	{
+		shutdown_time_counter = shutdown_time;
+		ShutdownRPi();
+		shutdown_flag = 0;
+		alarm_shutdown_enable = 0;
+
+
+		powerback_flag = 1;
+	}
+
+	if (warning_enable == 1 && warning_flag == 1 && shutdown_enable != 1)
+	{
+		PowerfailWarning();
+		warning_flag = 0;
+		powerback_flag = 1;
+	}
+}
+
+/*** notifyMainTask
+ * Posts an event (mainEvent...) to the main Task, from an interrupt as well as from another task ***/
+
+void notifyMainTask(uint32_t event)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if (defaultTaskHandle == NULL)
+	{
+		return;
+	}
+
+	if (__get_IPSR() != 0)
+	{
+		xTaskNotifyFromISR(defaultTaskHandle, event, eSetBits, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+	else
+	{
+		xTaskNotify(defaultTaskHandle, event, eSetBits);
+	}
+}
+
+/*** The RTC Alarm A fires at every full minute and starts the Alarm_Handler in the main Task ***/
+
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
+{
+	notifyMainTask(mainEventAlarm);
+}
+
+/*** waitMainEvents
+ * Waits up to the tick deadline (the start of the next loop period), but the posted events are processed
+ * as soon as they arrive, then the rest of the period is waited, so the 1-second counters of the main Task aren't affected ***/
+
+static void waitMainEvents(TickType_t deadline)
+{
+	TickType_t remaining;
+	uint32_t events;
+
+	while ((int32_t) (remaining = deadline - xTaskGetTickCount()) > 0)
+	{
+		if (xTaskNotifyWait(0, 0xFFFFFFFF, &events, remaining) == pdTRUE)
+		{
+			if (events & mainEventReconfigure)
+			{
+				reconfigureWatchdog();
+			}
+
+			/*** Only while the ADC-Watchdog is still disabled by the failover, it hasn't been re-armed in between ***/
+			if ((events & mainEventArmPowerBack) && awd_window == awdWindowFail && !__HAL_ADC_GET_IT_SOURCE(&hadc, ADC_IT_AWD))
+			{
+				armPowerBackWatchdog();
+			}
+
+			if (events & (mainEventPowerFail | mainEventShutdown))
+			{
+				processShutdownFlags();
+			}
+
+			if (events & mainEventPowerBack)
+			{
+				restorePrimary();
+			}
+
+			if (events & mainEventAlarm)
+			{
+				Alarm_Handler();
+				processShutdownFlags();
+			}
+		}
+	}
+}
+
 /*********************************************************************************/
 
 /*** Main Task
@@ -1437,13 +2597,19 @@ void initialCheck(void)
  * In the first part (before the main loop) the initial starting condition is prepared
  * and the UART serial console task is initiated.
  *
- * The main loop then is triggered every second by the FreeRTOS Taskscheduler
- * As this give a synchroned timesource, the main task is counting the seconds and after reaching
- * a full minute, its starts the Alarm_Handler()
+ * The main loop then is triggered every loop_period (usually a second) at a fixed rate by vTaskDelayUntil,
+ * so the work of the loop doesn't shift the following periods. Its execution time and the jitter of its start
+ * are recorded (see latency.h and the loop-stats command). The timers of the loop are only counted
+ * at every full second (second), when the period is shorter.
+ * The Alarm_Handler() isn't counted from these seconds, which are drifting with the work of the loop,
+ * but is started by the RTC Alarm A at every full minute of the RTC (mainEventAlarm)
  *
  * The next part is for the processing of the warning messages, as it would be to critical to
  * resolve them in the ADC Watchdog Interrupt, and for turning the primary PowerPath back on
  * after the ADC have detected that it came back to life.
+ * Between the seconds the main Task waits for events (waitMainEvents): the ADC-Watchdog failover, the power-back interrupt
+ * and the poweroff command wake it up immediately, so the messages are sent and the primary PowerPath is turned back on
+ * within milliseconds.
  *
  * The last part os for reading out the ADC and storing the values into variables for processing.
 
@@ -1456,8 +2622,19 @@ void StartDefaultTask(void const * argument)
 {
 
 	/* USER CODE BEGIN 5 */
-	uint16_t VDDValue;
-	uint8_t sek = 0;
+	TickType_t xLastWakeTime;
+	uint32_t loopStart;
+	uint32_t previousLoopStart = 0;
+	uint32_t period;
+	uint16_t loopMillis = 0;
+	uint8_t second;
+	uint8_t alive;
+	uint8_t reconfigure;
+
+	/*** The Cortex-M0 port doesn't reset the MSP when the scheduler starts, so the frame of main() would stay
+	 * on the interrupt stack. The main Task is the first task the scheduler runs and main() never returns,
+	 * so the MSP is reset to the end of the RAM here. The task itself runs on the PSP ***/
+	__set_MSP((uint32_t) &_estack);
 
 	interval_off_flag = 1;
 
@@ -1465,29 +2642,8 @@ void StartDefaultTask(void const * argument)
 
 	if (initstart == 0)
 	{
-		osDelay(500);
-		MX_ADC_Init();
-
-		if (modus == 1 || modus == 3)
-		{
-			Power_USB();
-			configureAWD_USB();
-		}
-		else if (modus == 2 || modus == 4)
-		{
-			Power_Wide();
-			configureAWD_Wide();
-		}
-
-		HAL_ADCEx_Calibration_Start(&hadc);
-
-		if (HAL_ADC_Start_DMA(&hadc, (uint32_t*) rawValue, 5) != HAL_OK)
-		{
-			return 0;
-		}
-
-		MX_USART1_UART_Init();
-
+		/*** The ADC-Watchdog and the serial interface have already been initialized in main() (see startProtection),
+		 * only the console is started here ***/
 		osDelay(1000);
 
 		serialLess_communication_on_flag = 0;
@@ -1498,19 +2654,27 @@ void StartDefaultTask(void const * argument)
 		vUARTCommandConsoleStart();
 	}
 
+	xLastWakeTime = xTaskGetTickCount();
+
 	for (;;)
 	{
+		/*** Jitter of the fixed-rate loop: deviation of the measured period from loop_period ***/
+		loopStart = Latency_Now();
+		if (previousLoopStart != 0)
+		{
+			period = loopStart - previousLoopStart;
+			Latency_Record(&latency_loop_jitter, period > loop_period * 1000UL ? period - loop_period * 1000UL : loop_period * 1000UL - period);
+		}
+		previousLoopStart = loopStart;
 
-		/*** Counts for a full minute and calls then the Alarm_Handler() ***/
-
-		if (sek == 60)
+		loopMillis += loop_period;
+		second = loopMillis >= 1000;
+		if (second)
 		{
-			Alarm_Handler();
-			sek = 0;
+			loopMillis -= 1000;
 		}
-		sek++;
 
-		if (serialLess_communication_off_counter == 5)
+		if (second && serialLess_communication_off_counter == 5)
 		{
 			osDelay(1000);
 
@@ -1520,7 +2684,7 @@ void StartDefaultTask(void const * argument)
 			serialLess_communication_off_counter--;
 		}
 
-		if (serialLessMode == 1 && serialLess_communication_on_flag != 1 && serialLess_communication_off_counter > 0)
+		if (second && serialLessMode == 1 && serialLess_communication_on_flag != 1 && serialLess_communication_off_counter > 0)
 		{
 			Config_Reset_Pin_Input_PullUP();
 			if (HAL_GPIO_ReadPin(RESET_Rasp_GPIO_Port, RESET_Rasp_Pin) == 0)
@@ -1550,98 +2714,24 @@ void StartDefaultTask(void const * argument)
 
 		if (threeStageMode > 0)
 		{
-			if (threeStageMode == 1)
+			alive = (rawValue[2] > minUSB_fail ? powerAvailableUSB : 0) | (rawValue[0] > minWide_fail ? powerAvailableWide : 0);
+			modus = PowerArbiter_ThreeStage(threeStageMode, modus, output_status, alive, availableSources(), &reconfigure);
+			if (reconfigure)
 			{
-				if (output_status == 1)
-				{
-					if (rawValue[0] > minWide)
-					{
-						modus = 1;
-					}
-					else
-					{
-						modus = 3;
-					}
-
-					if (watchdog_update == 0)
-					{
-						reconfigureWatchdog();
-						watchdog_update = 1;
-					}
-				}
-
-				else if (output_status == 0 || output_status == 2 || output_status == 3)
-				{
-					if (rawValue[2] > minUSB)
-					{
-						modus = 1;
-						watchdog_update = 0;
-					}
-					else
-					{
-						if (modus != 4)
-						{
-							modus = 4;
-							watchdog_update = 0;
-						}
-					}
-
-					if (watchdog_update == 0)
-					{
-						reconfigureWatchdog();
-						watchdog_update = 1;
-					}
-				}
+				watchdog_update = 0;
 			}
 
-			if (threeStageMode == 2)
+			if (watchdog_update == 0)
 			{
-				if (output_status == 2)
-				{
-					if (rawValue[2] > minUSB)
-					{
-						modus = 2;
-						watchdog_update = 0;
-					}
-
-					else
-					{
-						modus = 4;
-					}
-
-					if (watchdog_update == 0)
-					{
-						reconfigureWatchdog();
-						watchdog_update = 1;
-					}
-				}
-
-				else if (output_status == 0 || output_status == 1 || output_status == 3)
-				{
-					if (rawValue[0] > minWide)
-					{
-						modus = 2;
-						watchdog_update = 0;
-					}
-					else
-					{
-						if (modus != 3)
-						{
-							modus = 3;
-							watchdog_update = 0;
-						}
-					}
-
-					if (watchdog_update == 0)
-					{
-						reconfigureWatchdog();
-						watchdog_update = 1;
-					}
-				}
+				reconfigureWatchdog();
+				watchdog_update = 1;
 			}
 		}
 
-		if (poweroff_flag == 1 && power_on_button_counter <= powerOnButton_time)
+		/*** The three-stage-mode changes the backup source of the modus, so the fast failover is updated ***/
+		updateFailoverPath();
+
+		if (second && poweroff_flag == 1 && power_on_button_counter <= powerOnButton_time)
 		{
 			power_on_button_counter++;
 		}
@@ -1656,45 +2746,8 @@ void StartDefaultTask(void const * argument)
 				{
 					power_on_button_counter = 0;
 
-					if (modus == 1 || modus == 3)
-					{
-						if (rawValue[2] > minUSB)
-						{
-							poweroff_flag = 0;
-							Power_USB();
-						}
-						else if (modus == 1)
-						{
-							poweroff_flag = 0;
-							Power_Wide();
-						}
-						else if (modus == 3)
-						{
-							poweroff_flag = 0;
-							Power_Bat();
-							powerBat_flag = 1;
-						}
-					}
-
-					else if (modus == 2 || modus == 4)
-					{
-						if (rawValue[0] > minWide)
-						{
-							poweroff_flag = 0;
-							Power_Wide();
-						}
-						else if (modus == 2)
-						{
-							poweroff_flag = 0;
-							Power_USB();
-						}
-						else if (modus == 4)
-						{
-							poweroff_flag = 0;
-							Power_Bat();
-							powerBat_flag = 1;
-						}
-					}
+					/*** The power-on button turns the Raspberry Pi on in the same way as the wake alarm ***/
+					Alarm_PowerOn();
 					Config_Reset_Pin_Output();
 				}
 			}
@@ -1702,7 +2755,7 @@ void StartDefaultTask(void const * argument)
 
 		/*** If one of the Events have triggered the shutdown-timer,
 		 * then it here cuts off the Power to the Raspberry Pi  ***/
-		if (shutdown_time_counter > 0)
+		if (second && shutdown_time_counter > 0)
 		{
 			shutdown_time_counter--;
 
@@ -1717,7 +2770,7 @@ void StartDefaultTask(void const * argument)
 		 * the shutdown-process is shutting down the Powerpath
 		 * connected to the Raspberry Pi  ***/
 
-		if (alarm_shutdown_time_counter > 0)
+		if (second && alarm_shutdown_time_counter > 0)
 		{
 			alarm_shutdown_time_counter--;
 
@@ -1727,93 +2780,12 @@ void StartDefaultTask(void const * argument)
 			}
 		}
 
-		/*** Processing of the shutdown_flag
-		 * The Counter for the shutdown-timer is set
-		 * and the warning message for the Raspberry Pi Shutdown
-		 * is sent out through the serial interface  ***/
-
-		if (shutdown_enable == 1 && shutdown_flag == 1 || alarm_shutdown_enable == 1)
-		{
-			shutdown_time_counter = shutdown_time;
-			ShutdownRPi();
-			shutdown_flag = 0;
-			alarm_shutdown_enable = 0;
-
-
-			powerback_flag = 1;
-		}
-
-		/*** Processing of the warning_flag
-		 * If the shutdown-timer is deactivated, but the
-		 * warning feature is enabled, then here the powerfail-warning
-		 * is generated
-		 */
-
-		if (warning_enable == 1 && warning_flag == 1 && shutdown_enable != 1)
-		{
-			PowerfailWarning();
-			warning_flag = 0;
-			powerback_flag = 1;
-		}
-
-		/*** Turns the Raspberry Pi PowerPath backs on if the primary Voltage source has came back to life
-		 * Also the ADC-Watchdog-Interrupt is turned back on, so it can trigger once again.
-		 * The transition of the primary voltage source to the backup source, is monitored and will be
-		 * switched in the most critical manner (as soon as possible: directly in the ADC-Watchdog Interrupt),
-		 * but the transition from the backup source to the primary voltage is triggered here in the main Task
-		 * in its "1-second" period of time.
-		 */
-
-		if (modus == 1 || modus == 3)
-		{
-			if (rawValue[2] > minUSB && poweroff_flag != 1)
-			{
-				Power_USB();
-				__HAL_ADC_CLEAR_FLAG(&hadc, ADC_FLAG_AWD);
-				__HAL_ADC_ENABLE_IT(&hadc, ADC_IT_AWD);
-				if (serialLessMode)
-				{
-					HAL_GPIO_WritePin(RESET_Rasp_GPIO_Port, RESET_Rasp_Pin, GPIO_PIN_SET);
-					serialLess_communication_on_flag = 0;
-				}
-
-				shutdown_time_counter = 0;
-
-				powerBat_flag = 0;
-
-				if (powerback_flag == 1 && !(threeStageMode == 2 && output_status == 1))
-				{
-					PowerBack();
-					powerback_flag = 0;
-				}
-			}
-		}
-
-		if (modus == 2 || modus == 4)
-		{
-			if (rawValue[0] > minWide && poweroff_flag != 1)
-			{
-				Power_Wide();
-				__HAL_ADC_CLEAR_FLAG(&hadc, ADC_FLAG_AWD);
-				__HAL_ADC_ENABLE_IT(&hadc, ADC_IT_AWD);
-
-				if (serialLessMode)
-				{
-					HAL_GPIO_WritePin(RESET_Rasp_GPIO_Port, RESET_Rasp_Pin, GPIO_PIN_SET);
-					serialLess_communication_on_flag = 0;
-				}
-
-				shutdown_time_counter = 0;
+		/*** Processing of the shutdown_flag and warning_flag, which are usually already processed
+		 * through the events ***/
+		processShutdownFlags();
 
-				powerBat_flag = 0;
-
-				if (powerback_flag == 1 && !(threeStageMode == 1 && output_status == 2))
-				{
-					PowerBack();
-					powerback_flag = 0;
-				}
-			}
-		}
+		/*** Turns the Raspberry Pi PowerPath back on if the primary Voltage source has came back to life (see restorePrimary) ***/
+		restorePrimary();
 
 		if (powerBat_flag == 1 && interval_off_flag == 0)
 		{
@@ -1822,11 +2794,7 @@ void StartDefaultTask(void const * argument)
 
 		/*** Reads out the current ADC-Values and stores them into the linked variables ***/
 		HAL_ADCEx_Calibration_Start(&hadc);
-		VDDValue = 3300 * (*((unsigned short*) 0x1FFFF7BA)) / rawValue[4];
-		measuredValue[0] = VDDValue * rawValue[0] / 4095 * 105100 / 5100;
-		measuredValue[1] = VDDValue * rawValue[1] / 4095 * 15100 / 5100;
-		measuredValue[2] = VDDValue * rawValue[2] / 4095 * 15100 / 5100;
-		measuredValue[3] = VDDValue * rawValue[3] / 4095 * 15100 / 5100;
+		updateMeasuredValues();
 
 		/***
 		 * In this part the measured Battery Voltage is mapped on 4 Voltage-Levels
@@ -1880,31 +2848,13 @@ void StartDefaultTask(void const * argument)
 
 		}
 		powerfailure_counter_block = 0;
-		osDelay(1000);
-	}
-	/* USER CODE END 5 */
-}
 
-/**
- * @brief  Period elapsed callback in non blocking mode
- * @note   This function is called  when TIM14 interrupt took place, inside
- * HAL_TIM_IRQHandler(). It makes a direct call to HAL_IncTick() to increment
- * a global variable "uwTick" used as application time base.
- * @param  htim : TIM handle
- * @retval None
- */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
-{
-	/* USER CODE BEGIN Callback 0 */
+		Latency_Record(&latency_loop_execution, Latency_Now() - loopStart);
 
-	/* USER CODE END Callback 0 */
-	if (htim->Instance == TIM14)
-	{
-		HAL_IncTick();
+		waitMainEvents(xLastWakeTime + loop_period);
+		vTaskDelayUntil(&xLastWakeTime, loop_period);
 	}
-	/* USER CODE BEGIN Callback 1 */
-
-	/* USER CODE END Callback 1 */
+	/* USER CODE END 5 */
 }
 
 /**
@@ -0,0 +1,119 @@
+/*
+ * power_arbiter.c
+ *
+ * Arbitration of the PowerPath of the StromPi3
+ *
+ * Please refer to power_arbiter.h for the description of the modes.
+ */
+
+#include "power_arbiter.h"
+
+#define powerArbiterModes 7
+
+#define U powerSourceUSB
+#define W powerSourceWide
+#define B powerSourceBat
+#define N powerSourceNone
+
+/*** Source of the mode [modus][available]
+ * The primary source is selected when it is available, otherwise the backup source.
+ * The three-stage-modes 5 and 6 are replaced by the modes 1..4 at the start, so they select nothing ***/
+static const uint8_t selectTable[powerArbiterModes][4] =
+{
+	/*  none  USB  Wide  both */
+	{ N, N, N, N },
+	{ W, U, W, U },
+	{ U, U, W, W },
+	{ B, U, B, U },
+	{ B, B, W, W },
+	{ N, N, N, N },
+	{ N, N, N, N }
+};
+
+#undef U
+#undef W
+#undef B
+#undef N
+
+/*** The watchdog is reconfigured never, always or when the mode has changed ***/
+#define reconfigureNever 0
+#define reconfigureAlways 1
+#define reconfigureChanged 2
+
+typedef struct
+{
+	uint8_t modus;
+	uint8_t reconfigure;
+} ThreeStageTransition_t;
+
+/*** Three-stage transitions [threeStageMode - 1][output is the first stage][condition]
+ * - The output is the first stage: the condition is the second stage being alive (above its fail threshold),
+ *   which selects the backup source of the mode
+ * - Otherwise: the condition is the first stage being available again ***/
+static const ThreeStageTransition_t threeStageTable[2][2][2] =
+{
+	{
+		{ { 4, reconfigureChanged }, { 1, reconfigureAlways } },
+		{ { 3, reconfigureNever }, { 1, reconfigureNever } }
+	},
+	{
+		{ { 3, reconfigureChanged }, { 2, reconfigureAlways } },
+		{ { 4, reconfigureNever }, { 2, reconfigureAlways } }
+	}
+};
+
+/*** PowerArbiter_Select
+ * Returns the source, which powers the Raspberry Pi in the mode with the available sources ***/
+
+uint8_t PowerArbiter_Select(uint8_t modus, uint8_t available)
+{
+	if (modus >= powerArbiterModes)
+	{
+		return powerSourceNone;
+	}
+
+	return selectTable[modus][available & (powerAvailableUSB | powerAvailableWide)];
+}
+
+uint8_t PowerArbiter_Primary(uint8_t modus)
+{
+	return PowerArbiter_Select(modus, powerAvailableUSB | powerAvailableWide);
+}
+
+uint8_t PowerArbiter_Backup(uint8_t modus)
+{
+	return PowerArbiter_Select(modus, 0);
+}
+
+/*** PowerArbiter_ThreeStage
+ * Returns the mode of the three-stage-mode (1: mUSB -> Wide -> Battery, 2: Wide -> mUSB -> Battery)
+ * from the actual output, the alive and the available sources.
+ * reconfigure is set, when the ADC-Watchdog has to be reconfigured for the returned mode ***/
+
+uint8_t PowerArbiter_ThreeStage(uint8_t threeStageMode, uint8_t modus, uint8_t output, uint8_t alive, uint8_t available, uint8_t *reconfigure)
+{
+	const ThreeStageTransition_t *transition;
+	uint8_t first;
+	uint8_t second;
+	uint8_t onFirst;
+	uint8_t condition;
+
+	if (threeStageMode != 1 && threeStageMode != 2)
+	{
+		*reconfigure = 0;
+		return modus;
+	}
+
+	/*** The three-stage-modes start with the mode of the same number ***/
+	first = PowerArbiter_Primary(threeStageMode);
+	second = PowerArbiter_Backup(threeStageMode);
+
+	onFirst = output == first;
+	condition = onFirst ? (alive & powerAvailable(second)) != 0 : (available & powerAvailable(first)) != 0;
+
+	transition = &threeStageTable[threeStageMode - 1][onFirst][condition];
+
+	*reconfigure = transition->reconfigure == reconfigureAlways || (transition->reconfigure == reconfigureChanged && transition->modus != modus);
+
+	return transition->modus;
+}
@@ -0,0 +1,472 @@
+/*
+ * protocol.c
+ *
+ * Binary protocol of the StromPi3
+ *
+ * Please refer to protocol.h for the description of the frames.
+ */
+
+#include <string.h>
+#include "protocol.h"
+#include "uart_tx.h"
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_CLI.h"
+
+/*** type, seq and crc ***/
+#define protocolHeaderSize 2
+#define protocolCrcSize 4
+#define protocolFrameSize (protocolHeaderSize + protocolDataMax + protocolCrcSize)
+
+#define protocolRequestSize (protocolHeaderSize + protocolRequestMax + protocolCrcSize)
+
+/*** COBS adds one byte per 254 bytes, the frame is enclosed by two delimiters ***/
+#define protocolEncodedSize (protocolFrameSize + protocolFrameSize / 254 + 3)
+#define protocolEncodedRequestSize (protocolRequestSize + protocolRequestSize / 254 + 1)
+
+#define protocolEventFrameSize (protocolHeaderSize + 1 + protocolCrcSize + 3)
+
+/*** States of the reception ***/
+#define protocolIdle 0
+#define protocolCollect 1
+#define protocolDiscard 2
+
+extern RTC_HandleTypeDef hrtc;
+extern char firmwareVersion[9];
+
+/*** The request, the answer and its encoding are kept in the output buffer of the serial console.
+ * The console task processes the frames only between two commands and UartTx_Bulk() returns after the answer
+ * has been sent, so the buffer is free. The answer is encoded over the request, which has been processed then ***/
+#define protocolRx ((uint8_t *) FreeRTOS_CLIGetOutputBuffer())
+#define protocolFrame (protocolRx + protocolEncodedRequestSize)
+#define protocolTx protocolRx
+
+#if protocolEncodedSize > protocolEncodedRequestSize
+#error "The encoded answer doesn't fit in front of the answer"
+#endif
+
+#if protocolEncodedRequestSize + protocolFrameSize > configCOMMAND_INT_MAX_OUTPUT_SIZE
+#error "The frames don't fit into the output buffer of the serial console"
+#endif
+
+static uint8_t protocolRxLength;
+static uint8_t protocolRxState;
+static uint8_t protocolLength;
+
+/*** The event frames are sent by the event lane of the transmit queue, which needs them until they have been sent ***/
+static uint8_t protocolEventTx[3][protocolEventFrameSize];
+static uint8_t protocolEventSeq;
+static uint8_t protocolEventsEnabled;
+
+/*** CRC-32 with the CRC unit: the input is reversed bytewise and the output is reversed,
+ * so the result matches the standard CRC-32 after the final inversion.
+ * The console task and the main task can both send frames, so the scheduler is suspended during the computation ***/
+
+static uint32_t crc32(const uint8_t *data, uint16_t length)
+{
+	uint32_t crc;
+
+	vTaskSuspendAll();
+
+	__HAL_RCC_CRC_CLK_ENABLE();
+	CRC->INIT = 0xFFFFFFFF;
+	CRC->CR = CRC_CR_REV_IN_0 | CRC_CR_REV_OUT | CRC_CR_RESET;
+
+	while (length--)
+	{
+		*(__IO uint8_t *) &CRC->DR = *data++;
+	}
+
+	crc = ~CRC->DR;
+
+	xTaskResumeAll();
+
+	return crc;
+}
+
+/*** Returns the length of the encoded data with both delimiters ***/
+
+static uint16_t cobsEncode(const uint8_t *data, uint16_t length, uint8_t *encoded)
+{
+	uint16_t code = 1;
+	uint16_t out = 2;
+	uint8_t code_position = 1;
+
+	encoded[0] = 0x00;
+
+	while (length--)
+	{
+		if (*data != 0x00)
+		{
+			encoded[out++] = *data;
+			code++;
+		}
+		if (*data == 0x00 || code == 0xFF)
+		{
+			encoded[code_position] = code;
+			code_position = out++;
+			code = 1;
+		}
+		data++;
+	}
+
+	encoded[code_position] = code;
+	encoded[out++] = 0x00;
+
+	return out;
+}
+
+/*** Decodes in place, returns the decoded length or 0 for an invalid encoding ***/
+
+static uint16_t cobsDecode(uint8_t *data, uint16_t length)
+{
+	uint16_t in = 0;
+	uint16_t out = 0;
+	uint8_t code;
+	uint8_t index;
+
+	while (in < length)
+	{
+		code = data[in++];
+		if (code == 0x00 || in + code - 1 > length)
+		{
+			return 0;
+		}
+		for (index = 1; index < code; index++)
+		{
+			data[out++] = data[in++];
+		}
+		if (code < 0xFF && in < length)
+		{
+			data[out++] = 0x00;
+		}
+	}
+
+	return out;
+}
+
+static void put8(uint8_t value)
+{
+	if (protocolLength < protocolHeaderSize + protocolDataMax)
+	{
+		protocolFrame[protocolLength++] = value;
+	}
+}
+
+static void put16(uint16_t value)
+{
+	put8(value);
+	put8(value >> 8);
+}
+
+static void put32(uint32_t value)
+{
+	put16(value);
+	put16(value >> 16);
+}
+
+static uint32_t get32(const uint8_t *data)
+{
+	return data[0] | (data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+/*** Starts the answer to a request with its result ***/
+
+static void answer(uint8_t type, uint8_t seq, uint8_t result)
+{
+	protocolFrame[0] = type | protocolResponse;
+	protocolFrame[1] = seq;
+	protocolLength = protocolHeaderSize;
+	put8(result);
+}
+
+/*** Appends the crc to the frame and queues it into the bulk lane of the transmit queue ***/
+
+static void send(void)
+{
+	uint32_t crc = crc32(protocolFrame, protocolLength);
+
+	protocolFrame[protocolLength++] = crc;
+	protocolFrame[protocolLength++] = crc >> 8;
+	protocolFrame[protocolLength++] = crc >> 16;
+	protocolFrame[protocolLength++] = crc >> 24;
+
+	UartTx_Bulk(protocolTx, cobsEncode(protocolFrame, protocolLength, protocolTx));
+}
+
+static void putStatus(void)
+{
+	RTC_TimeTypeDef time;
+	RTC_DateTypeDef date;
+	uint8_t alarm_mode = 0;
+
+	/*** The date has to be read after the time to unlock the shadow registers ***/
+	HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
+	HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BIN);
+
+	if (alarmTime == 1)
+		alarm_mode = 1;
+	else if (alarmDate == 1)
+		alarm_mode = 2;
+	else if (alarmWeekDay == 1)
+		alarm_mode = 3;
+
+	put8(time.Hours);
+	put8(time.Minutes);
+	put8(time.Seconds);
+	put8(date.Year);
+	put8(date.Month);
+	put8(date.Date);
+	put8(date.WeekDay);
+	put8(threeStageMode > 0 ? threeStageMode + 4 : modus);
+	put8(alarm_enable);
+	put8(alarm_mode);
+	put8(alarm_hour);
+	put8(alarm_min);
+	put8(alarm_day);
+	put8(alarm_month);
+	put8(alarm_weekday);
+	put8(alarmPoweroff);
+	put8(alarm_hour_off);
+	put8(alarm_min_off);
+	put8(shutdown_enable);
+	put16(shutdown_time);
+	put8(warning_enable);
+	put8(serialLessMode);
+	put8(alarmInterval);
+	put16(alarmIntervalMinOn);
+	put16(alarmIntervalMinOff);
+	put8(batLevel_shutdown);
+	put8(batLevel);
+	put8(charging);
+	put8(powerOnButton_enable);
+	put16(powerOnButton_time);
+	put8(powersave_enable);
+	put8(poweroff_enable);
+	put8(wakeup_time_enable);
+	put16(wakeup_time);
+	put8(wakeupweekend_enable);
+	put16(measuredValue[0]);
+	put16(measuredValue[1]);
+	put16(measuredValue[2]);
+	put16(measuredValue[3]);
+	put8(output_status);
+	put16(powerfailure_counter);
+}
+
+static void putString(const char *string)
+{
+	while (*string)
+	{
+		put8(*string++);
+	}
+}
+
+/*** Processes a decoded frame and sends the answer ***/
+
+static void process(const uint8_t *frame, uint16_t length)
+{
+	uint8_t type = frame[0];
+	uint8_t seq = frame[1];
+	const uint8_t *data = frame + protocolHeaderSize;
+	uint16_t dataLength = length - protocolHeaderSize - protocolCrcSize;
+	uint8_t index;
+
+	if (crc32(frame, length - protocolCrcSize) != get32(frame + length - protocolCrcSize))
+	{
+		answer(type, seq, protocolErrorCrc);
+		send();
+		return;
+	}
+
+	switch (type)
+	{
+	case protocolPing:
+		answer(type, seq, protocolOk);
+		put8(protocolVersion);
+		putString(firmwareVersion);
+		break;
+
+	case protocolStatus:
+		answer(type, seq, protocolOk);
+		putStatus();
+		putString(firmwareVersion);
+		break;
+
+	case protocolMeasurement:
+		answer(type, seq, protocolOk);
+		for (index = 0; index < 5; index++)
+		{
+			put16(measuredValue[index]);
+		}
+		put8(output_status);
+		put8(batLevel);
+		put8(charging);
+		put16(powerfailure_counter);
+		break;
+
+	case protocolConfigGet:
+		if (dataLength != 2)
+		{
+			answer(type, seq, protocolErrorLength);
+		}
+		else if (data[0] + data[1] > configMax || data[1] > (protocolDataMax - 2) / 4)
+		{
+			answer(type, seq, protocolErrorRange);
+		}
+		else
+		{
+			answer(type, seq, protocolOk);
+			put8(data[0]);
+			for (index = data[0]; index < data[0] + data[1]; index++)
+			{
+				put32(configParamters[index]);
+			}
+		}
+		break;
+
+	case protocolConfigSet:
+		if (dataLength != 5)
+		{
+			answer(type, seq, protocolErrorLength);
+		}
+		else if (data[0] >= configMax)
+		{
+			answer(type, seq, protocolErrorRange);
+		}
+		else
+		{
+			/*** A repeated request sets the same value again, so it can be repeated without harm ***/
+			setConfig(data[0], get32(data + 1));
+			answer(type, seq, protocolOk);
+			put8(data[0]);
+			put32(configParamters[data[0]]);
+		}
+		break;
+
+	case protocolConfigSetAll:
+		if (dataLength != 1 + 2 * (configMax - 1) || data[0] != configMax - 1)
+		{
+			answer(type, seq, protocolErrorLength);
+		}
+		else
+		{
+			index = setConfigAll(data + 1);
+			if (index == 0)
+			{
+				answer(type, seq, protocolOk);
+				put8(data[0]);
+			}
+			else
+			{
+				answer(type, seq, protocolErrorRange);
+				put8(index);
+			}
+		}
+		break;
+
+	case protocolEvents:
+		if (dataLength != 1)
+		{
+			answer(type, seq, protocolErrorLength);
+		}
+		else
+		{
+			protocolEventsEnabled = data[0] != 0;
+			answer(type, seq, protocolOk);
+		}
+		break;
+
+	default:
+		answer(type, seq, protocolErrorType);
+		break;
+	}
+
+	send();
+}
+
+/*** Protocol_Receive
+ * Is called by the console task with every received character, returns 1, when the character belongs to a frame.
+ * A 0x00 opens a frame and the next 0x00 closes it, an empty frame (0x00 0x00) keeps the reception open,
+ * so a script can resynchronize by sending 0x00 before every frame ***/
+
+uint8_t Protocol_Receive(uint8_t data)
+{
+	uint16_t length;
+
+	switch (protocolRxState)
+	{
+	case protocolIdle:
+		if (data != 0x00)
+		{
+			return 0;
+		}
+		protocolRxLength = 0;
+		protocolRxState = protocolCollect;
+		break;
+
+	case protocolCollect:
+		if (data != 0x00)
+		{
+			if (protocolRxLength < protocolEncodedRequestSize)
+			{
+				protocolRx[protocolRxLength++] = data;
+			}
+			else
+			{
+				protocolRxState = protocolDiscard;
+			}
+		}
+		else if (protocolRxLength > 0)
+		{
+			protocolRxState = protocolIdle;
+
+			/*** Frames too short for type, seq and crc are dropped ***/
+			length = cobsDecode(protocolRx, protocolRxLength);
+			if (length >= protocolHeaderSize + protocolCrcSize)
+			{
+				process(protocolRx, length);
+			}
+		}
+		break;
+
+	default:
+		if (data == 0x00)
+		{
+			protocolRxState = protocolIdle;
+		}
+		break;
+	}
+
+	return 1;
+}
+
+/*** Protocol_Event
+ * Sends an event frame (protocolEventShutdown, protocolEventPowerfail or protocolEventPowerBack)
+ * by the event lane of the transmit queue, when the event frames have been turned on ***/
+
+void Protocol_Event(uint8_t code)
+{
+	uint8_t frame[protocolHeaderSize + 1 + protocolCrcSize];
+	uint8_t *encoded;
+	uint32_t crc;
+
+	if (!protocolEventsEnabled || code < protocolEventShutdown || code > protocolEventPowerBack)
+	{
+		return;
+	}
+
+	frame[0] = protocolEvent;
+	frame[1] = protocolEventSeq++;
+	frame[2] = code;
+
+	crc = crc32(frame, protocolHeaderSize + 1);
+	frame[3] = crc;
+	frame[4] = crc >> 8;
+	frame[5] = crc >> 16;
+	frame[6] = crc >> 24;
+
+	encoded = protocolEventTx[code - protocolEventShutdown];
+	UartTx_Event(encoded, cobsEncode(frame, sizeof(frame), encoded));
+}
@@ -0,0 +1,349 @@
+/*
+ * schedule.c
+ *
+ * Schedule table of the StromPi3
+ *
+ * Please refer to schedule.h for the description of the entries.
+ */
+
+#include <string.h>
+#include "schedule.h"
+#include "main.h"
+
+/*** Days, which are searched for the next firing entry (a combination of weekday and day of the month can be rare) ***/
+#define scheduleSearchDays 400
+
+typedef struct
+{
+	uint8_t year;
+	uint8_t month;
+	uint8_t date;
+	uint8_t weekday;
+	uint16_t minute; /*** Minute of the day ***/
+} ScheduleTime_t;
+
+extern RTC_HandleTypeDef hrtc;
+
+uint32_t schedule_next = scheduleNever;
+
+static uint8_t schedulePendingIndex = SCHEDULE_ENTRIES;
+static ScheduleEntry_t schedulePendingEntry;
+static ScheduleEntry_t scheduleCopy[SCHEDULE_ENTRIES];
+static uint16_t scheduleIntervalCounter;
+
+static const uint16_t monthStart[12] =
+{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+static const uint8_t monthDays[12] =
+{ 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+static uint8_t daysInMonth(uint8_t month, uint8_t year)
+{
+	if (month == 2 && year % 4 == 0)
+	{
+		return 29;
+	}
+	return monthDays[month - 1];
+}
+
+/*** Minutes since 2000-01-01 00:00 (the RTC counts the years 2000 to 2099, so every fourth year is a leap year) ***/
+
+static uint32_t stamp(const ScheduleTime_t *t)
+{
+	uint32_t day = t->year * 365UL + (t->year + 3) / 4 + monthStart[t->month - 1] + t->date - 1;
+
+	if (t->month > 2 && t->year % 4 == 0)
+	{
+		day++;
+	}
+
+	return day * 1440 + t->minute;
+}
+
+static void nextDay(ScheduleTime_t *t)
+{
+	t->date++;
+	if (t->date > daysInMonth(t->month, t->year))
+	{
+		t->date = 1;
+		t->month++;
+		if (t->month > 12)
+		{
+			t->month = 1;
+			t->year++;
+		}
+	}
+	t->weekday = t->weekday % 7 + 1;
+	t->minute = 0;
+}
+
+/*** The date can be set to anything through the serial console ***/
+
+static uint8_t isValid(const ScheduleTime_t *t)
+{
+	return t->month >= 1 && t->month <= 12 && t->date >= 1 && t->date <= daysInMonth(t->month, t->year) && t->weekday >= 1 && t->weekday <= 7;
+}
+
+static uint8_t isActive(const ScheduleEntry_t *entry)
+{
+	return entry->action >= scheduleWake && entry->action <= scheduleInterval;
+}
+
+static uint8_t dayMatches(const ScheduleEntry_t *entry, const ScheduleTime_t *t)
+{
+	return (entry->weekdays & (1 << (t->weekday - 1))) && (entry->days & (1UL << (t->date - 1)));
+}
+
+/*** Returns the first minute of the day from the minute "from" on, at which the entry fires, or -1 ***/
+
+static int16_t firstMinute(const ScheduleEntry_t *entry, uint16_t from)
+{
+	uint8_t hour;
+	uint8_t minute;
+
+	for (hour = from / 60; hour < 24; hour++)
+	{
+		if (entry->hour != scheduleEvery && entry->hour != hour)
+		{
+			continue;
+		}
+
+		minute = (hour == from / 60) ? from % 60 : 0;
+
+		if (entry->minute == scheduleEvery)
+		{
+			return hour * 60 + minute;
+		}
+		if (entry->minute >= minute && entry->minute < 60)
+		{
+			return hour * 60 + entry->minute;
+		}
+	}
+
+	return -1;
+}
+
+/*** Searches the next firing entry after the minute now and stores its minute stamp into schedule_next ***/
+
+static void computeNext(const ScheduleTime_t *now)
+{
+	ScheduleTime_t t = *now;
+	const ScheduleEntry_t *entry;
+	uint16_t day;
+	uint8_t index;
+	int16_t minute;
+	int16_t first;
+
+	if (!isValid(&t))
+	{
+		schedule_next = scheduleNever;
+		return;
+	}
+
+	if (t.minute == 1439)
+	{
+		nextDay(&t);
+	}
+	else
+	{
+		t.minute++;
+	}
+
+	for (day = 0; day < scheduleSearchDays; day++)
+	{
+		first = -1;
+
+		for (index = 0; index < SCHEDULE_ENTRIES; index++)
+		{
+			entry = Schedule_Get(index);
+			if (!isActive(entry) || !dayMatches(entry, &t))
+			{
+				continue;
+			}
+
+			minute = firstMinute(entry, t.minute);
+			if (minute >= 0 && (first < 0 || minute < first))
+			{
+				first = minute;
+			}
+		}
+
+		if (first >= 0)
+		{
+			t.minute = first;
+			schedule_next = stamp(&t);
+			return;
+		}
+
+		nextDay(&t);
+	}
+
+	schedule_next = scheduleNever;
+}
+
+static void getTime(ScheduleTime_t *t, const RTC_TimeTypeDef *time, const RTC_DateTypeDef *date)
+{
+	t->year = date->Year;
+	t->month = date->Month;
+	t->date = date->Date;
+	t->weekday = date->WeekDay;
+	t->minute = time->Hours * 60 + time->Minutes;
+}
+
+static void readTime(ScheduleTime_t *t)
+{
+	RTC_TimeTypeDef time;
+	RTC_DateTypeDef date;
+
+	/*** The date has to be read after the time to unlock the shadow registers ***/
+	HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
+	HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BIN);
+
+	getTime(t, &time, &date);
+}
+
+/*** Schedule_Reschedule
+ * Searches the next firing entry from the actual RTC time on,
+ * is called at the start, after the table has been changed and after the RTC has been set ***/
+
+void Schedule_Reschedule(void)
+{
+	ScheduleTime_t now;
+
+	readTime(&now);
+	computeNext(&now);
+}
+
+uint32_t Schedule_Now(void)
+{
+	ScheduleTime_t now;
+
+	readTime(&now);
+	return stamp(&now);
+}
+
+/*** Schedule_Handler
+ * Is called by the Alarm_Handler() at every full minute with the actual RTC time,
+ * the entries are only evaluated when the precomputed minute stamp has been reached ***/
+
+void Schedule_Handler(const RTC_TimeTypeDef *time, const RTC_DateTypeDef *date)
+{
+	ScheduleTime_t now;
+	const ScheduleEntry_t *entry;
+	uint32_t stampNow;
+	uint8_t index;
+
+	if (scheduleIntervalCounter > 0)
+	{
+		scheduleIntervalCounter--;
+		if (scheduleIntervalCounter == 0 && poweroff_flag == 0)
+		{
+			Alarm_PowerOff();
+		}
+	}
+
+	getTime(&now, time, date);
+	if (!isValid(&now))
+	{
+		return;
+	}
+	stampNow = stamp(&now);
+
+	if (stampNow < schedule_next)
+	{
+		return;
+	}
+
+	/*** If the RTC has jumped over the stamp, the missed entries aren't fired, only the next one is searched ***/
+	if (stampNow == schedule_next)
+	{
+		for (index = 0; index < SCHEDULE_ENTRIES; index++)
+		{
+			entry = Schedule_Get(index);
+			if (!isActive(entry) || !dayMatches(entry, &now) || firstMinute(entry, now.minute) != now.minute)
+			{
+				continue;
+			}
+
+			if (entry->action == scheduleShutdown)
+			{
+				if (poweroff_flag == 0)
+				{
+					Alarm_PowerOff();
+				}
+			}
+			else
+			{
+				if (poweroff_flag == 1)
+				{
+					Alarm_PowerOn();
+				}
+				if (entry->action == scheduleInterval)
+				{
+					scheduleIntervalCounter = alarmIntervalMinOn;
+				}
+			}
+		}
+	}
+
+	computeNext(&now);
+}
+
+/*** Schedule_Get
+ * The entries are read directly from the flash ***/
+
+const ScheduleEntry_t *Schedule_Get(uint8_t index)
+{
+	return (const ScheduleEntry_t *) schedule_FlashAdress + index;
+}
+
+/*** Schedule_Set
+ * The flash page holds the configuration as well, so flashConfig() rewrites the whole page
+ * and takes the changed entry from Schedule_Copy() ***/
+
+void Schedule_Set(uint8_t index, const ScheduleEntry_t *entry)
+{
+	if (index >= SCHEDULE_ENTRIES)
+	{
+		return;
+	}
+
+	schedulePendingEntry = *entry;
+	schedulePendingIndex = index;
+
+	flashConfig();
+	Schedule_Reschedule();
+}
+
+/*** Schedule_Copy
+ * Copies the table (with a pending change of Schedule_Set) before flashConfig() erases the flash page.
+ * The copy is static, because flashConfig() runs on the small stack of the console task as well ***/
+
+void Schedule_Copy(void)
+{
+	memcpy(scheduleCopy, (const void *) schedule_FlashAdress, sizeof(scheduleCopy));
+
+	if (schedulePendingIndex < SCHEDULE_ENTRIES)
+	{
+		scheduleCopy[schedulePendingIndex] = schedulePendingEntry;
+		schedulePendingIndex = SCHEDULE_ENTRIES;
+	}
+}
+
+/*** Schedule_Flash
+ * Programs the table after the erase of the flash page in flashConfig() ***/
+
+void Schedule_Flash(void)
+{
+	const uint32_t *word = (const uint32_t *) scheduleCopy;
+	uint8_t index;
+
+	for (index = 0; index < SCHEDULE_ENTRIES * sizeof(ScheduleEntry_t) / 4; index++)
+	{
+		/*** Empty entries are left erased ***/
+		if (word[index] != 0xFFFFFFFF)
+		{
+			flashValue(schedule_FlashAdress + 4 * index, word[index]);
+		}
+	}
+}
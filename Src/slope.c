@@ -0,0 +1,28 @@
+/*
+ * slope.c
+ *
+ * Slope comparisons of the predictive brown-out detection of the StromPi3
+ *
+ * Please refer to slope.h for the description of the comparisons.
+ */
+
+#include "slope.h"
+
+/*** Slope_Exceeds
+ * Returns 1, if drop [ADC-Value] over time [us] is at least rate [ADC-Value/ms]:
+ *
+ *   drop * 1000 >= rate * time ***/
+
+uint8_t Slope_Exceeds(uint16_t drop, uint32_t time, uint16_t rate)
+{
+	return (uint64_t) drop * 1000 >= (uint64_t) rate * time;
+}
+
+/*** Slope_Steeper
+ * Returns 1, if drop over time is steeper than the peak slope peak_drop over peak_time,
+ * or if there isn't a peak slope yet (peak_time 0) ***/
+
+uint8_t Slope_Steeper(uint16_t drop, uint32_t time, uint16_t peak_drop, uint32_t peak_time)
+{
+	return peak_time == 0 || (uint64_t) drop * peak_time > (uint64_t) peak_drop * time;
+}
@@ -61,7 +61,6 @@
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-TIM_HandleTypeDef        htim14; 
 uint32_t                 uwIncrementState = 0;
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
@@ -81,6 +80,9 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
   uint32_t              uwTimclock = 0;
   uint32_t              uwPrescalerValue = 0;
   uint32_t              pFLatency;
+  /* The handle is only needed for the initialization, the tick interrupt and
+     the tickless idle use the registers of TIM14 */
+  TIM_HandleTypeDef     htim14 = { 0 };
   
   /*Configure the TIM14 IRQ priority */
   HAL_NVIC_SetPriority(TIM14_IRQn, TickPriority ,0); 
@@ -132,7 +134,7 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
 void HAL_SuspendTick(void)
 {
   /* Disable TIM14 update Interrupt */
-  __HAL_TIM_DISABLE_IT(&htim14, TIM_IT_UPDATE);                                                  
+  TIM14->DIER &= ~TIM_DIER_UIE;
 }
 
 /**
@@ -144,7 +146,7 @@ void HAL_SuspendTick(void)
 void HAL_ResumeTick(void)
 {
   /* Enable TIM14 Update interrupt */
-  __HAL_TIM_ENABLE_IT(&htim14, TIM_IT_UPDATE);
+  TIM14->DIER |= TIM_DIER_UIE;
 }
 
 /**
@@ -38,16 +38,18 @@
 
 /* USER CODE BEGIN 0 */
 #include "FreeRTOS.h"
+#include "latency.h"
+#include "task_stats.h"
+#include "uart_tx.h"
 extern void vUARTInterruptHandler( void );
+extern void vUARTCommandConsoleRxEvent( void );
+extern void powerBackDebounceElapsed( void );
 
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
-extern DMA_HandleTypeDef hdma_adc;
 extern ADC_HandleTypeDef hadc;
-extern UART_HandleTypeDef huart1;
-
-extern TIM_HandleTypeDef htim14;
+extern RTC_HandleTypeDef hrtc;
 
 /******************************************************************************/
 /*            Cortex-M0 Processor Interruption and Exception Handlers         */ 
@@ -105,29 +107,86 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f0xx.s).                    */
 /******************************************************************************/
 
+/**
+* @brief This function handles RTC interrupt through EXTI lines 17, 19 and 20.
+*/
+void RTC_IRQHandler(void)
+{
+  /* USER CODE BEGIN RTC_IRQn 0 */
+
+  /* USER CODE END RTC_IRQn 0 */
+  HAL_RTC_AlarmIRQHandler(&hrtc);
+  /* USER CODE BEGIN RTC_IRQn 1 */
+
+  /* USER CODE END RTC_IRQn 1 */
+}
+
 /**
 * @brief This function handles DMA1 channel 1 interrupt.
 */
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
+  /* A half of the circular ADC buffer has been filled (startADC() in main.c) */
+  uint32_t flags = DMA1->ISR;
 
+  DMA1->IFCR = flags & (DMA_IFCR_CHTIF1 | DMA_IFCR_CTCIF1);
+  if (flags & DMA_ISR_HTIF1)
+  {
+    HAL_ADC_ConvHalfCpltCallback(&hadc);
+  }
+  if (flags & DMA_ISR_TCIF1)
+  {
+    HAL_ADC_ConvCpltCallback(&hadc);
+  }
   /* USER CODE END DMA1_Channel1_IRQn 0 */
-  HAL_DMA_IRQHandler(&hdma_adc);
   /* USER CODE BEGIN DMA1_Channel1_IRQn 1 */
-
+  TaskStats_CountISR(TASK_STATS_ISR_DMA);
   /* USER CODE END DMA1_Channel1_IRQn 1 */
 }
 
+/**
+* @brief This function handles DMA1 channel 2 and 3 interrupts.
+*/
+void DMA1_Channel2_3_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 0 */
+  /* Channel 3: a half of the circular receive buffer of the console has been filled */
+  if (DMA1->ISR & (DMA_ISR_HTIF3 | DMA_ISR_TCIF3))
+  {
+    DMA1->IFCR = DMA_IFCR_CHTIF3 | DMA_IFCR_CTCIF3;
+    vUARTCommandConsoleRxEvent();
+  }
+  /* USER CODE END DMA1_Channel2_3_IRQn 0 */
+  /* USER CODE BEGIN DMA1_Channel2_3_IRQn 1 */
+  UartTx_IRQHandler();
+  TaskStats_CountISR(TASK_STATS_ISR_DMA);
+  /* USER CODE END DMA1_Channel2_3_IRQn 1 */
+}
+
 /**
 * @brief This function handles ADC interrupt.
 */
 void ADC1_IRQHandler(void)
 {
   /* USER CODE BEGIN ADC1_IRQn 0 */
+  /* ADC-Watchdog: the fast failover switches the PowerPath before any HAL processing */
+  if (__HAL_ADC_GET_FLAG(&hadc, ADC_FLAG_AWD) && __HAL_ADC_GET_IT_SOURCE(&hadc, ADC_IT_AWD) && awd_window == awdWindowFail)
+  {
+    latency_awd_timestamp = Latency_Now();
+    if (failover_bsrr != 0)
+    {
+      GPIOA->BSRR = failover_bsrr;
+      latency_switch_timestamp = Latency_Now();
+    }
+  }
 
+  /* The HAL processing calls the FreeRTOS API, so it is deferred to the lower priority of ADC_Deferred_IRQn (see main.h),
+     the ADC1 interrupt stays disabled until it has been processed */
+  NVIC_DisableIRQ(ADC1_IRQn);
+  NVIC_SetPendingIRQ(ADC_Deferred_IRQn);
+  TaskStats_CountISR(TASK_STATS_ISR_ADC);
   /* USER CODE END ADC1_IRQn 0 */
-  HAL_ADC_IRQHandler(&hadc);
   /* USER CODE BEGIN ADC1_IRQn 1 */
 
   /* USER CODE END ADC1_IRQn 1 */
@@ -139,29 +198,65 @@ void ADC1_IRQHandler(void)
 void TIM14_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM14_IRQn 0 */
-
+  /* TIM14 is the HAL timebase, its update interrupt is handled through the registers */
+  if (TIM14->SR & TIM_SR_UIF)
+  {
+    TIM14->SR = ~TIM_SR_UIF;
+    HAL_IncTick();
+  }
   /* USER CODE END TIM14_IRQn 0 */
-  HAL_TIM_IRQHandler(&htim14);
   /* USER CODE BEGIN TIM14_IRQn 1 */
-
+  TaskStats_CountISR(TASK_STATS_ISR_TIM14);
   /* USER CODE END TIM14_IRQn 1 */
 }
 
+/**
+* @brief This function handles TIM16 global interrupt.
+*/
+void TIM16_IRQHandler(void)
+{
+  /* USER CODE BEGIN TIM16_IRQn 0 */
+  /* TIM16 only runs the one-shot power-back debounce, which is handled through its registers */
+  if (TIM16->SR & TIM_SR_UIF)
+  {
+    TIM16->SR = ~TIM_SR_UIF;
+    powerBackDebounceElapsed();
+  }
+  /* USER CODE END TIM16_IRQn 0 */
+  /* USER CODE BEGIN TIM16_IRQn 1 */
+
+  /* USER CODE END TIM16_IRQn 1 */
+}
+
 /**
 * @brief This function handles USART1 global interrupt / USART1 wake-up interrupt through EXTI line 25.
 */
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
-
+  /* Idle line after received characters: the console takes them from the DMA receive buffer.
+     Only the idle line interrupt is enabled, the errors are cleared with it, the DMA reception keeps running */
+  if (USART1->ISR & USART_ISR_IDLE)
+  {
+    USART1->ICR = USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_NCF | USART_ICR_FECF;
+    vUARTCommandConsoleRxEvent();
+  }
   /* USER CODE END USART1_IRQn 0 */
-  HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
-
+  TaskStats_CountISR(TASK_STATS_ISR_USART1);
   /* USER CODE END USART1_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+* @brief This function handles the ADC interrupt deferred by ADC1_IRQHandler (TIM17 vector).
+*/
+void TIM17_IRQHandler(void)
+{
+  HAL_ADC_IRQHandler(&hadc);
+  NVIC_EnableIRQ(ADC1_IRQn);
+}
+
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,60 @@
+/*
+ * task_stats.c
+ *
+ * Runtime task statistics of the StromPi3
+ *
+ * Please refer to task_stats.h for the description of the statistics.
+ */
+
+#include "task_stats.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+volatile uint32_t task_stats_isr_count[TASK_STATS_ISRS];
+
+static uint32_t taskStatsLastTime;
+static uint32_t taskStatsLastRunTime[TASK_STATS_TASKS];
+static uint32_t taskStatsLastISR[TASK_STATS_ISRS];
+
+/*** TaskStats_Sample
+ * The differences of the counters since the last call are correct over a wrap of the 32-bit counters,
+ * the run times are stored by the task number (the tasks are never deleted).
+ * The status array is static to keep it off the console stack, only the console task samples ***/
+
+void TaskStats_Sample(TaskStats_t *stats)
+{
+	static TaskStatus_t status[TASK_STATS_TASKS];
+	uint32_t time;
+	uint32_t runTime;
+	uint32_t count;
+	UBaseType_t number;
+	uint8_t index;
+
+	stats->tasks = uxTaskGetSystemState(status, TASK_STATS_TASKS, &time);
+	stats->interval = time - taskStatsLastTime;
+	stats->idle = 0;
+	taskStatsLastTime = time;
+
+	for (index = 0; index < stats->tasks; index++)
+	{
+		number = (status[index].xTaskNumber - 1) % TASK_STATS_TASKS;
+		runTime = status[index].ulRunTimeCounter - taskStatsLastRunTime[number];
+		taskStatsLastRunTime[number] = status[index].ulRunTimeCounter;
+
+		stats->task[index].name = status[index].pcTaskName;
+		stats->task[index].share = (stats->interval > 0) ? (uint64_t) runTime * 1000 / stats->interval : 0;
+		stats->task[index].stackFree = status[index].usStackHighWaterMark * sizeof(StackType_t);
+
+		if (status[index].xHandle == xTaskGetIdleTaskHandle())
+		{
+			stats->idle = stats->task[index].share;
+		}
+	}
+
+	for (index = 0; index < TASK_STATS_ISRS; index++)
+	{
+		count = task_stats_isr_count[index];
+		stats->isr[index] = count - taskStatsLastISR[index];
+		taskStatsLastISR[index] = count;
+	}
+}
@@ -0,0 +1,169 @@
+/*
+ * uart_baud.c
+ *
+ * Baudrate negotiation of the serial interface of the StromPi3
+ *
+ * Please refer to uart_baud.h for the description of the negotiation.
+ */
+
+#include "uart_baud.h"
+#include "uart_tx.h"
+#include "main.h"
+#include "task.h"
+
+/*** Baudrates, which the USART1 (48 MHz, 16 times oversampling) and the UART of the Raspberry Pi can both reach ***/
+static const uint32_t uartBaudRates[] =
+{ 38400, 57600, 115200, 230400, 460800, 500000, 921600, 1000000 };
+
+static uint32_t uartBaudRate = uartBaudDefault;
+static uint32_t uartBaudRequested;
+static uint8_t uartBaudPending;
+static TickType_t uartBaudSwitchTime;
+static TickType_t uartBaudReceiveTime;
+
+/*** Set by UartBaud_Default() in the main Task, the console task does the switch ***/
+static volatile uint8_t uartBaudFallback;
+static TaskHandle_t uartBaudTask;
+
+/*** Sends the queued output with the old baudrate and reprograms the baudrate register of the USART1.
+ * The DMA reception of the console keeps running, the transmit queue is held meanwhile,
+ * so an event message of an interrupt isn't started on the disabled USART1 ***/
+
+static void setRate(uint32_t rate)
+{
+	UartTx_Suspend();
+
+	USART1->CR1 &= ~USART_CR1_UE;
+	USART1->BRR = UART_DIV_SAMPLING16(HAL_RCC_GetPCLK1Freq(), rate);
+	USART1->CR1 |= USART_CR1_UE;
+	uartBaudRate = rate;
+
+	UartTx_Resume();
+}
+
+/*** UartBaud_Request
+ * Is called by the command set-baud, the switch is done by UartBaud_Process() after the answer of the command.
+ * Returns 0, if the baudrate isn't supported ***/
+
+uint8_t UartBaud_Request(uint32_t rate)
+{
+	uint8_t index;
+
+	for (index = 0; index < sizeof(uartBaudRates) / sizeof(uartBaudRates[0]); index++)
+	{
+		if (uartBaudRates[index] == rate)
+		{
+			uartBaudRequested = rate;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*** UartBaud_Confirm
+ * Keeps the negotiated baudrate, returns 0, if there isn't any switch to confirm ***/
+
+uint8_t UartBaud_Confirm(void)
+{
+	if (!uartBaudPending)
+	{
+		return 0;
+	}
+
+	uartBaudPending = 0;
+	return 1;
+}
+
+uint32_t UartBaud_Rate(void)
+{
+	return uartBaudRate;
+}
+
+/*** UartBaud_Received
+ * Is called by the console task with every received character, the idle time is counted from the last one ***/
+
+void UartBaud_Received(void)
+{
+	uartBaudReceiveTime = xTaskGetTickCount();
+}
+
+/*** UartBaud_Default
+ * Returns to uartBaudDefault, when the Raspberry Pi is shut down or powered off (ShutdownRPi()), so the scripts
+ * find the StromPi3 at uartBaudDefault after the next boot. The event lane is held until the console task has switched,
+ * so the shutdown message queued after the call is sent with uartBaudDefault to the shutdown script ***/
+
+void UartBaud_Default(void)
+{
+	if (uartBaudRate == uartBaudDefault && uartBaudRequested == 0 && !uartBaudPending)
+	{
+		return;
+	}
+
+	UartTx_HoldEvents();
+	uartBaudFallback = 1;
+
+	if (uartBaudTask != NULL)
+	{
+		xTaskNotifyGive(uartBaudTask);
+	}
+}
+
+/*** UartBaud_Process
+ * Is called by the console task before it waits for characters: it switches to a requested baudrate
+ * and returns to uartBaudDefault, when the switch hasn't been confirmed in time, when nothing has been received
+ * for uartBaudIdleTime or when UartBaud_Default() has been called.
+ * Returns the time the console task may wait ***/
+
+TickType_t UartBaud_Process(void)
+{
+	TickType_t now = xTaskGetTickCount();
+	TickType_t elapsed;
+	TickType_t timeout;
+
+	uartBaudTask = xTaskGetCurrentTaskHandle();
+
+	if (uartBaudFallback)
+	{
+		uartBaudFallback = 0;
+		uartBaudRequested = 0;
+		uartBaudPending = 0;
+		setRate(uartBaudDefault);
+		UartTx_ReleaseEvents();
+		return 0;
+	}
+
+	if (uartBaudRequested != 0)
+	{
+		setRate(uartBaudRequested);
+		uartBaudRequested = 0;
+		uartBaudPending = 1;
+		uartBaudSwitchTime = now;
+		uartBaudReceiveTime = now;
+		return 0;
+	}
+
+	if (uartBaudPending)
+	{
+		elapsed = now - uartBaudSwitchTime;
+		timeout = uartBaudConfirmTime / portTICK_RATE_MS;
+	}
+	else if (uartBaudRate != uartBaudDefault)
+	{
+		elapsed = now - uartBaudReceiveTime;
+		timeout = uartBaudIdleTime / portTICK_RATE_MS;
+	}
+	else
+	{
+		return portMAX_DELAY;
+	}
+
+	if (elapsed >= timeout)
+	{
+		uartBaudPending = 0;
+		setRate(uartBaudDefault);
+		return 0;
+	}
+
+	return timeout - elapsed;
+}
@@ -0,0 +1,260 @@
+/*
+ * uart_tx.c
+ *
+ * Transmit queue of the serial interface of the StromPi3
+ *
+ * Please refer to uart_tx.h for the description of the lanes.
+ */
+
+#include "uart_tx.h"
+#include "stm32f0xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*** Time after which a waiting task checks the lanes again, the console task takes its notifications
+ * for the received characters and for the transmit queue with the same ulTaskNotifyTake() ***/
+#define uartTxWaitTime (10UL / portTICK_RATE_MS)
+
+typedef struct
+{
+	const uint8_t *message;
+	uint16_t length;
+} UartTxEvent_t;
+
+static UartTxEvent_t uartTxEvent[uartTxEvents];
+static uint8_t uartTxEventHead;
+static volatile uint8_t uartTxEventCount;
+
+static const uint8_t *uartTxBulk;
+static volatile uint16_t uartTxBulkCount;
+
+/*** Length of the running transfer from the bulk lane, 0 for an event message ***/
+static uint16_t uartTxSending;
+static volatile uint8_t uartTxBusy;
+
+/*** No transfer is started between UartTx_Suspend() and UartTx_Resume() ***/
+static uint8_t uartTxSuspended;
+
+/*** No event message is started between UartTx_HoldEvents() and UartTx_ReleaseEvents() ***/
+static volatile uint8_t uartTxEventsHeld;
+
+static TaskHandle_t volatile uartTxWaitingTask;
+
+/*** Programs the DMA1 Channel 2 for a transfer into the transmit register of the USART1.
+ * The channel is driven through its registers, so it doesn't need a HAL handle in the RAM ***/
+
+static void startDMA(const uint8_t *data, uint16_t length)
+{
+	DMA1_Channel2->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF2;
+
+	DMA1_Channel2->CPAR = (uint32_t) &USART1->TDR;
+	DMA1_Channel2->CMAR = (uint32_t) data;
+	DMA1_Channel2->CNDTR = length;
+	DMA1_Channel2->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_EN;
+
+	/*** The DMA request of the transmitter is set with the transfer, the interrupts are disabled here, because
+	 * the console sets the DMA request of the receiver in the same register (CR3) ***/
+	USART1->ICR = USART_ICR_TCCF;
+	USART1->CR3 |= USART_CR3_DMAT;
+
+	uartTxBusy = 1;
+}
+
+/*** Starts the next transfer, has to be called with disabled interrupts ***/
+
+static void startTransfer(void)
+{
+	const UartTxEvent_t *event;
+	uint16_t length;
+
+	if (uartTxBusy || uartTxSuspended)
+	{
+		return;
+	}
+
+	if (uartTxEventCount > 0 && !uartTxEventsHeld)
+	{
+		event = &uartTxEvent[uartTxEventHead];
+		uartTxSending = 0;
+		startDMA(event->message, event->length);
+		return;
+	}
+
+	if (uartTxBulkCount > 0)
+	{
+		length = uartTxBulkCount;
+		if (length > uartTxBulkPiece)
+		{
+			length = uartTxBulkPiece;
+		}
+
+		uartTxSending = length;
+		startDMA(uartTxBulk, length);
+	}
+}
+
+/*** UartTx_Event
+ * Queues a message into the event lane, the message has to stay valid until it has been sent.
+ * It can be called from the tasks and from the interrupts, if the event lane is full, the message is dropped ***/
+
+void UartTx_Event(const uint8_t *message, uint16_t length)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	if (uartTxEventCount < uartTxEvents)
+	{
+		uartTxEvent[(uartTxEventHead + uartTxEventCount) % uartTxEvents].message = message;
+		uartTxEvent[(uartTxEventHead + uartTxEventCount) % uartTxEvents].length = length;
+		uartTxEventCount++;
+	}
+
+	startTransfer();
+
+	__set_PRIMASK(primask);
+}
+
+/*** UartTx_Bulk
+ * Sends the data by the bulk lane, the calling task is blocked until the last piece has been sent,
+ * so the data don't need to stay valid after the return. Only the console task uses the bulk lane ***/
+
+void UartTx_Bulk(const uint8_t *data, uint16_t length)
+{
+	if (length == 0)
+	{
+		return;
+	}
+
+	uartTxWaitingTask = xTaskGetCurrentTaskHandle();
+
+	__disable_irq();
+
+	uartTxBulk = data;
+	uartTxBulkCount = length;
+	startTransfer();
+
+	__enable_irq();
+
+	while (uartTxBulkCount > 0)
+	{
+		ulTaskNotifyTake(pdTRUE, uartTxWaitTime);
+	}
+
+	uartTxWaitingTask = NULL;
+}
+
+/*** UartTx_Suspend
+ * Blocks the calling task until both lanes have been sent and holds the queue, so the USART1 can be reprogrammed.
+ * Held event messages (UartTx_HoldEvents()) stay queued. The messages queued in the meantime are sent after UartTx_Resume() ***/
+
+void UartTx_Suspend(void)
+{
+	uartTxWaitingTask = xTaskGetCurrentTaskHandle();
+
+	while (1)
+	{
+		/*** The check and the hold are done together, so an interrupt can't start a transfer in between ***/
+		__disable_irq();
+		if (!uartTxBusy && (uartTxEventCount == 0 || uartTxEventsHeld) && uartTxBulkCount == 0)
+		{
+			uartTxSuspended = 1;
+			__enable_irq();
+			break;
+		}
+		startTransfer();
+		__enable_irq();
+
+		ulTaskNotifyTake(pdTRUE, uartTxWaitTime);
+	}
+
+	uartTxWaitingTask = NULL;
+
+	/*** The DMA is done, when it has written the last byte into the USART1, which still shifts it out ***/
+	while ((USART1->ISR & USART_ISR_TC) == 0)
+	{
+	}
+}
+
+/*** UartTx_Resume
+ * Releases the queue after UartTx_Suspend() ***/
+
+void UartTx_Resume(void)
+{
+	__disable_irq();
+
+	uartTxSuspended = 0;
+	startTransfer();
+
+	__enable_irq();
+}
+
+/*** UartTx_HoldEvents
+ * Holds the event lane, a running transfer is finished and the bulk lane is still sent.
+ * Is used to send the messages queued afterwards with the next baudrate (uart_baud.c) ***/
+
+void UartTx_HoldEvents(void)
+{
+	uartTxEventsHeld = 1;
+}
+
+/*** UartTx_ReleaseEvents
+ * Sends the event messages held since UartTx_HoldEvents() ***/
+
+void UartTx_ReleaseEvents(void)
+{
+	__disable_irq();
+
+	uartTxEventsHeld = 0;
+	startTransfer();
+
+	__enable_irq();
+}
+
+/*** UartTx_IRQHandler
+ * Is called from the interrupt of the DMA1 Channel 2 and 3. When a transfer is complete, the next one is started,
+ * a transfer error restarts the transfer, so the message is sent again ***/
+
+void UartTx_IRQHandler(void)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	uint32_t primask = __get_PRIMASK();
+	uint32_t flags = DMA1->ISR;
+
+	if (!uartTxBusy || (flags & (DMA_ISR_TCIF2 | DMA_ISR_TEIF2)) == 0)
+	{
+		return;
+	}
+
+	__disable_irq();
+
+	DMA1_Channel2->CCR = 0;
+	DMA1->IFCR = DMA_IFCR_CGIF2;
+
+	if (flags & DMA_ISR_TEIF2)
+	{
+		/*** The lanes are left as they are, so the same message or piece is started again ***/
+	}
+	else if (uartTxSending == 0)
+	{
+		uartTxEventHead = (uartTxEventHead + 1) % uartTxEvents;
+		uartTxEventCount--;
+	}
+	else
+	{
+		uartTxBulk += uartTxSending;
+		uartTxBulkCount -= uartTxSending;
+	}
+
+	uartTxBusy = 0;
+	startTransfer();
+
+	__set_PRIMASK(primask);
+
+	if (uartTxWaitingTask != NULL)
+	{
+		vTaskNotifyGiveFromISR(uartTxWaitingTask, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
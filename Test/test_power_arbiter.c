@@ -0,0 +1,257 @@
+/*
+ * test_power_arbiter.c
+ *
+ * Host test of the power_arbiter of the StromPi3
+ *
+ * The power_arbiter (see power_arbiter.h) has replaced the if/else branches of the main Task,
+ * the ADC-Watchdog failover, the wake alarm and the power-on button. This test enumerates every mode
+ * and every input and compares the tables with the replaced branches, which are kept here as reference.
+ *
+ * Build and run on the host (the power_arbiter doesn't depend on the HAL):
+ *
+ *   make -C Test
+ *
+ * The program prints the number of compared cases and returns 1, when any case differs.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "power_arbiter.h"
+
+static unsigned int cases;
+static unsigned int errors;
+
+static void check(const char *name, int expected, int actual, int modus, int a, int b, int c)
+{
+	cases++;
+	if (expected != actual)
+	{
+		errors++;
+		printf("%s: modus %d (%d, %d, %d): expected %d, got %d\n", name, modus, a, b, c, expected, actual);
+	}
+}
+
+/*** Replaced branches ***/
+
+/*** Alarm_PowerOn() and the power-on button: primary source if stable, otherwise the backup source ***/
+static uint8_t referenceSelect(uint8_t modus, uint8_t stableUSB, uint8_t stableWide)
+{
+	if (modus == 1 || modus == 3)
+	{
+		if (stableUSB)
+			return powerSourceUSB;
+		else if (modus == 1)
+			return powerSourceWide;
+		else
+			return powerSourceBat;
+	}
+	else if (modus == 2 || modus == 4)
+	{
+		if (stableWide)
+			return powerSourceWide;
+		else if (modus == 2)
+			return powerSourceUSB;
+		else
+			return powerSourceBat;
+	}
+
+	return powerSourceNone;
+}
+
+/*** main(): source turned on at the start ***/
+static uint8_t referencePrimary(uint8_t modus)
+{
+	if (modus == 1 || modus == 3)
+		return powerSourceUSB;
+	else if (modus == 2 || modus == 4)
+		return powerSourceWide;
+
+	return powerSourceNone;
+}
+
+/*** HAL_ADC_LevelOutOfWindowCallback() and updateFailoverPath(): source after the failover ***/
+static uint8_t referenceBackup(uint8_t modus)
+{
+	if (modus == 1)
+		return powerSourceWide;
+	else if (modus == 2)
+		return powerSourceUSB;
+	else if (modus == 3 || modus == 4)
+		return powerSourceBat;
+
+	return powerSourceNone;
+}
+
+/*** restorePrimary(): the power-back message, the output already is the primary source ***/
+static uint8_t referencePowerBack(uint8_t threeStageMode, uint8_t primary)
+{
+	uint8_t output_status = primary;
+
+	if (primary == powerSourceUSB)
+		return !(threeStageMode == 2 && output_status == 1);
+	else
+		return !(threeStageMode == 1 && output_status == 2);
+}
+
+static uint8_t arbiterPowerBack(uint8_t threeStageMode, uint8_t primary)
+{
+	return threeStageMode == 0 || PowerArbiter_Primary(threeStageMode) == primary;
+}
+
+/*** Three-stage logic of the main Task, *watchdog_update is its state between the runs ***/
+static uint8_t referenceThreeStage(uint8_t threeStageMode, uint8_t modus, uint8_t output_status,
+		uint8_t aliveUSB, uint8_t aliveWide, uint8_t stableUSB, uint8_t stableWide, uint8_t *watchdog_update, uint8_t *reconfigured)
+{
+	*reconfigured = 0;
+
+	if (threeStageMode == 1)
+	{
+		if (output_status == 1)
+		{
+			if (aliveWide)
+				modus = 1;
+			else
+				modus = 3;
+		}
+		else
+		{
+			if (stableUSB)
+			{
+				modus = 1;
+				*watchdog_update = 0;
+			}
+			else if (modus != 4)
+			{
+				modus = 4;
+				*watchdog_update = 0;
+			}
+		}
+	}
+
+	if (threeStageMode == 2)
+	{
+		if (output_status == 2)
+		{
+			if (aliveUSB)
+			{
+				modus = 2;
+				*watchdog_update = 0;
+			}
+			else
+				modus = 4;
+		}
+		else
+		{
+			if (stableWide)
+			{
+				modus = 2;
+				*watchdog_update = 0;
+			}
+			else if (modus != 3)
+			{
+				modus = 3;
+				*watchdog_update = 0;
+			}
+		}
+	}
+
+	if (*watchdog_update == 0)
+	{
+		*reconfigured = 1;
+		*watchdog_update = 1;
+	}
+
+	return modus;
+}
+
+/*** The main Task with the power_arbiter ***/
+static uint8_t arbiterThreeStage(uint8_t threeStageMode, uint8_t modus, uint8_t output_status,
+		uint8_t alive, uint8_t available, uint8_t *watchdog_update, uint8_t *reconfigured)
+{
+	uint8_t reconfigure;
+
+	*reconfigured = 0;
+
+	modus = PowerArbiter_ThreeStage(threeStageMode, modus, output_status, alive, available, &reconfigure);
+	if (reconfigure)
+	{
+		*watchdog_update = 0;
+	}
+
+	if (*watchdog_update == 0)
+	{
+		*reconfigured = 1;
+		*watchdog_update = 1;
+	}
+
+	return modus;
+}
+
+int main(void)
+{
+	uint8_t modus;
+	uint8_t available;
+	uint8_t alive;
+	uint8_t threeStageMode;
+	uint8_t output;
+	uint8_t update;
+	uint8_t referenceUpdate;
+	uint8_t arbiterUpdate;
+	uint8_t referenceReconfigured;
+	uint8_t arbiterReconfigured;
+	uint8_t referenceModus;
+	uint8_t arbiterModus;
+
+	for (modus = 0; modus < 10; modus++)
+	{
+		check("primary", referencePrimary(modus), PowerArbiter_Primary(modus), modus, 0, 0, 0);
+		check("backup", referenceBackup(modus), PowerArbiter_Backup(modus), modus, 0, 0, 0);
+
+		for (available = 0; available < 4; available++)
+		{
+			check("select", referenceSelect(modus, available & powerAvailableUSB, available & powerAvailableWide),
+					PowerArbiter_Select(modus, available), modus, available, 0, 0);
+		}
+	}
+
+	for (threeStageMode = 0; threeStageMode < 3; threeStageMode++)
+	{
+		for (modus = 1; modus <= 4; modus++)
+		{
+			check("powerback", referencePowerBack(threeStageMode, referencePrimary(modus)),
+					arbiterPowerBack(threeStageMode, PowerArbiter_Primary(modus)), modus, threeStageMode, 0, 0);
+		}
+	}
+
+	for (threeStageMode = 1; threeStageMode <= 2; threeStageMode++)
+	{
+		for (modus = 1; modus <= 4; modus++)
+		{
+			for (output = 0; output <= powerSourceBat; output++)
+			{
+				for (alive = 0; alive < 4; alive++)
+				{
+					for (available = 0; available < 4; available++)
+					{
+						for (update = 0; update < 2; update++)
+						{
+							referenceUpdate = update;
+							arbiterUpdate = update;
+
+							referenceModus = referenceThreeStage(threeStageMode, modus, output, alive & powerAvailableUSB, alive & powerAvailableWide,
+									available & powerAvailableUSB, available & powerAvailableWide, &referenceUpdate, &referenceReconfigured);
+							arbiterModus = arbiterThreeStage(threeStageMode, modus, output, alive, available, &arbiterUpdate, &arbiterReconfigured);
+
+							check("three-stage modus", referenceModus, arbiterModus, modus, threeStageMode, output, alive << 4 | available << 1 | update);
+							check("three-stage reconfigure", referenceReconfigured, arbiterReconfigured, modus, threeStageMode, output, alive << 4 | available << 1 | update);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	printf("power_arbiter: %u cases, %u errors\n", cases, errors);
+
+	return errors != 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * test_slope.c
+ *
+ * Host test of the slope comparisons of the StromPi3
+ *
+ * The slope estimator compares a drop over a time in microseconds, which covers up to
+ * 64 seconds at adc_rate 1 (see updateSlopeEstimator in main.c). This test compares the
+ * functions of slope.h over the whole range of the ADC-Values, of slope_rate (validateConfig)
+ * and of the history time with a reference in double precision, which is exact for these products.
+ *
+ * Build and run on the host:
+ *
+ *   make -C Test
+ *
+ * The program prints the number of compared cases and returns 1, when any case differs.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "slope.h"
+
+/*** Longest history: 2 * slopeWindow * adcOversampling scans at adc_rate 1 ***/
+#define maxTime 64000000UL
+
+static unsigned int cases;
+static unsigned int errors;
+
+static void check(const char *name, int expected, int actual, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	cases++;
+	if (expected != actual)
+	{
+		errors++;
+		printf("%s (%lu, %lu, %lu, %lu): expected %d, got %d\n", name, (unsigned long) a, (unsigned long) b, (unsigned long) c, (unsigned long) d,
+				expected, actual);
+	}
+}
+
+/*** Replaced comparisons in double precision ***/
+
+static int referenceExceeds(uint16_t drop, uint32_t time, uint16_t rate)
+{
+	return (double) drop * 1000.0 >= (double) rate * (double) time;
+}
+
+static int referenceSteeper(uint16_t drop, uint32_t time, uint16_t peak_drop, uint32_t peak_time)
+{
+	return peak_time == 0 || (double) drop * (double) peak_time > (double) peak_drop * (double) time;
+}
+
+static const uint32_t times[] =
+{ 0, 1, 999, 1000, 1001, 65535, 65536, 1048575, 1048576, 1048577, 1000000, 4194304, 16000000, 32000000, 63999999, maxTime };
+
+static const uint16_t values[] =
+{ 0, 1, 2, 19, 20, 21, 67, 68, 100, 255, 256, 1000, 1024, 2047, 2048, 4094, 4095 };
+
+#define count(array) (sizeof(array) / sizeof(array[0]))
+
+int main(void)
+{
+	unsigned int drop;
+	unsigned int rate;
+	unsigned int time;
+	unsigned int peak;
+	unsigned int peak_time;
+	uint32_t t;
+
+	for (drop = 0; drop < count(values); drop++)
+	{
+		for (rate = 0; rate < count(values); rate++)
+		{
+			for (time = 0; time < count(times); time++)
+			{
+				check("exceeds", referenceExceeds(values[drop], times[time], values[rate]), Slope_Exceeds(values[drop], times[time], values[rate]),
+						values[drop], times[time], values[rate], 0);
+
+				/*** Around the threshold of the comparison ***/
+				if (values[rate] != 0)
+				{
+					t = (uint32_t) values[drop] * 1000 / values[rate];
+					check("exceeds", referenceExceeds(values[drop], t, values[rate]), Slope_Exceeds(values[drop], t, values[rate]), values[drop], t,
+							values[rate], 0);
+					check("exceeds", referenceExceeds(values[drop], t + 1, values[rate]), Slope_Exceeds(values[drop], t + 1, values[rate]),
+							values[drop], t + 1, values[rate], 0);
+				}
+
+				for (peak = 0; peak < count(values); peak++)
+				{
+					for (peak_time = 0; peak_time < count(times); peak_time++)
+					{
+						check("steeper", referenceSteeper(values[drop], times[time], values[peak], times[peak_time]),
+								Slope_Steeper(values[drop], times[time], values[peak], times[peak_time]), values[drop], times[time], values[peak],
+								times[peak_time]);
+					}
+				}
+			}
+		}
+	}
+
+	/*** A slow drop over the longest history must not exceed slope_rate 604, whose 32-bit product wrapped to 1294336 ***/
+	check("long history", 0, Slope_Exceeds(1295, maxTime, 604), 1295, maxTime, 604, 0);
+
+	printf("slope: %u cases, %u errors\n", cases, errors);
+
+	return errors != 0;
+}